@@ -42,6 +42,7 @@ struct Block {
   using vid_size_t   = uint32_t;
   using vid_fps_t    = uint32_t;
   using aud_rate_t   = uint32_t;
+  using is_key_t     = uint32_t;
   using id_camera_t  = uint32_t;
   using block_size_t = uint32_t;
   using timestamp_t  = uint32_t;
@@ -55,6 +56,7 @@ struct Block {
   vid_fps_t vid_fps{};
   aud_rate_t aud_rate{};
   FourCC fourcc{};
+  bool is_key{false};
   id_camera_t id_camera{};
   std::size_t block_size{};
   std::time_t timestamp;
@@ -71,8 +73,15 @@ struct Block {
 
   static Block read(const cs::Buffer& buffer, const std::size_t offset = 0);
 
+  // NOTE: 'header' holds (at least) the SIZE_BLOCK_HEADER bytes located at
+  //       'offset' of a file with 'size' bytes.
+  static Block readHeader(const cs::Buffer& header,
+                          const std::size_t offset, const std::size_t size);
+
 private:
   bool _is_valid{false};
 
   Block(const cs::Buffer& buffer, const std::size_t offsBuffer) noexcept;
+
+  void parse(const cs::Buffer& buffer, const std::size_t offsBuffer);
 };
@@ -0,0 +1,81 @@
+/****************************************************************************
+** Copyright (c) 2023, Carsten Schmidt. All rights reserved.
+**
+** Redistribution and use in source and binary forms, with or without
+** modification, are permitted provided that the following conditions
+** are met:
+**
+** 1. Redistributions of source code must retain the above copyright
+**    notice, this list of conditions and the following disclaimer.
+**
+** 2. Redistributions in binary form must reproduce the above copyright
+**    notice, this list of conditions and the following disclaimer in the
+**    documentation and/or other materials provided with the distribution.
+**
+** 3. Neither the name of the copyright holder nor the names of its
+**    contributors may be used to endorse or promote products derived from
+**    this software without specific prior written permission.
+**
+** THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+** "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+** LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+** A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+** HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+** SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+** LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+** DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+** THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+** (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+** OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*****************************************************************************/
+
+#pragma once
+
+#include <filesystem>
+
+#include <cs/IO/File.h>
+
+#include "block.h"
+#include "toc.h"
+#include "wrap.h"
+
+// NOTE: Random access to the blocks of a file without reading it as a whole;
+//       only the headers are read while walking the block chain.
+//       first() and next() walk the blocks in chronological order (cf.
+//       forEachBlock()) once the wrap point is known; see findWrap().
+
+class BlockFile {
+public:
+  BlockFile() noexcept;
+
+  BlockFile(const BlockFile&)            = delete;
+  BlockFile& operator=(const BlockFile&) = delete;
+
+  bool open(const std::filesystem::path& path);
+  bool isOpen() const;
+
+  const std::filesystem::path& path() const;
+  std::size_t size() const;
+
+  std::size_t read(const std::size_t offset, void *data, const std::size_t size) const;
+
+  Toc readToc() const;
+
+  Block readBlock(const std::size_t offset);
+  Block resync(const std::size_t pos);
+
+  const Wrap& findWrap(const std::time_t threshold = 5);
+  const Wrap& wrap() const;
+
+  Block first();
+  Block next(const Block& block);
+
+  bool readData(const Block& block, cs::Buffer& data) const;
+
+private:
+  cs::File _file;
+  cs::Buffer _header;
+  std::filesystem::path _path;
+  std::size_t _size{0};
+  Wrap _wrap;
+};
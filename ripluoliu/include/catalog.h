@@ -0,0 +1,98 @@
+/****************************************************************************
+** Copyright (c) 2023, Carsten Schmidt. All rights reserved.
+**
+** Redistribution and use in source and binary forms, with or without
+** modification, are permitted provided that the following conditions
+** are met:
+**
+** 1. Redistributions of source code must retain the above copyright
+**    notice, this list of conditions and the following disclaimer.
+**
+** 2. Redistributions in binary form must reproduce the above copyright
+**    notice, this list of conditions and the following disclaimer in the
+**    documentation and/or other materials provided with the distribution.
+**
+** 3. Neither the name of the copyright holder nor the names of its
+**    contributors may be used to endorse or promote products derived from
+**    this software without specific prior written permission.
+**
+** THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+** "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+** LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+** A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+** HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+** SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+** LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+** DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+** THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+** (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+** OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*****************************************************************************/
+
+#pragma once
+
+#include <ctime>
+
+#include <filesystem>
+#include <ostream>
+#include <string>
+#include <vector>
+
+#include "toc.h"
+
+// NOTE: The catalog stores the time intervals of every file and stream of a
+//       directory tree; only the TOC of each file is read to build it.
+//       A saved catalog holds the fixed-size intervals, sorted and with
+//       max_end, ahead of the variable-length file records; hence, a query
+//       binary-searches the intervals in place and reads only the files of
+//       the matching intervals.
+
+class Catalog {
+public:
+  using mtime_t = int64_t;
+
+  struct File {
+    std::string path;
+    mtime_t mtime{};
+    uint64_t size{};
+    std::time_t tim_begin{};
+    std::time_t tim_end{};
+  };
+
+  struct Interval {
+    Toc::id_camera_t id_camera{};
+    Toc::id_stream_t id_stream{};
+    uint32_t id_file{};
+    std::time_t tim_begin{};
+    std::time_t tim_end{};
+    std::time_t max_end{}; // of all preceding intervals of the same camera
+  };
+
+  Catalog() noexcept;
+
+  std::size_t numFiles() const;
+  std::size_t numIntervals() const;
+
+  const File& file(const std::size_t id_file) const;
+
+  bool load(const std::filesystem::path& path);
+
+  // NOTE: Load only the intervals of 'id_camera' covering 't' and their files.
+  bool load(const std::filesystem::path& path,
+            const Toc::id_camera_t id_camera, const std::time_t t);
+  bool save(const std::filesystem::path& path) const;
+
+  // NOTE: Only files added or modified since the last refresh are read.
+  void refresh(const std::vector<std::filesystem::path>& roots);
+
+  std::vector<const Interval *> query(const Toc::id_camera_t id_camera,
+                                      const std::time_t t) const;
+
+  void print(std::ostream *stream, const Interval *interval) const;
+
+private:
+  void index();
+
+  std::vector<File> _files;
+  std::vector<Interval> _intervals;
+};
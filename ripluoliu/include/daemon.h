@@ -0,0 +1,137 @@
+/****************************************************************************
+** Copyright (c) 2023, Carsten Schmidt. All rights reserved.
+**
+** Redistribution and use in source and binary forms, with or without
+** modification, are permitted provided that the following conditions
+** are met:
+**
+** 1. Redistributions of source code must retain the above copyright
+**    notice, this list of conditions and the following disclaimer.
+**
+** 2. Redistributions in binary form must reproduce the above copyright
+**    notice, this list of conditions and the following disclaimer in the
+**    documentation and/or other materials provided with the distribution.
+**
+** 3. Neither the name of the copyright holder nor the names of its
+**    contributors may be used to endorse or promote products derived from
+**    this software without specific prior written permission.
+**
+** THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+** "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+** LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+** A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+** HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+** SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+** LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+** DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+** THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+** (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+** OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*****************************************************************************/
+
+#pragma once
+
+#include <ctime>
+
+#include <filesystem>
+#include <list>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "blockfile.h"
+#include "streammap.h"
+
+// NOTE: The FileIndex holds the TOC, the headers of all blocks (in
+//       chronological order) and the stream mappings of a file; it stays
+//       valid as long as the file is neither modified nor replaced. It does
+//       not keep the file open; every request opens its own BlockFile.
+
+class FileIndex {
+public:
+  using StreamKey = std::pair<Block::id_stream_t, FourCC>;
+
+  FileIndex() noexcept;
+
+  FileIndex(const FileIndex&)            = delete;
+  FileIndex& operator=(const FileIndex&) = delete;
+
+  bool isCurrent() const;
+  std::size_t memory() const;
+
+  const std::filesystem::path& path() const;
+
+  const Toc& toc() const;
+  const std::vector<Block>& blocks() const;
+
+  // NOTE: Returns nullptr if the stream does not exist.
+  const StreamMap *map(const Block::id_stream_t id_stream, const FourCC& fourcc) const;
+
+  // NOTE: Open the indexed file for reading; fails if its size changed.
+  bool open(BlockFile *file) const;
+
+  static std::shared_ptr<const FileIndex> build(const std::filesystem::path& path);
+
+private:
+  std::filesystem::path _path;
+  std::filesystem::file_time_type _mtime;
+  std::size_t _size{0};
+  Toc _toc;
+  std::vector<Block> _blocks;
+  std::map<StreamKey, StreamMap> _maps;
+};
+
+using FileIndexPtr = std::shared_ptr<const FileIndex>;
+
+// NOTE: IndexCache keeps the most recently used indexes as long as their
+//       accumulated memory does not exceed 'capacity'; at least one index is
+//       always kept. Evicted indexes stay alive while still in use.
+
+class IndexCache {
+public:
+  IndexCache(const std::size_t capacity) noexcept;
+
+  IndexCache(const IndexCache&)            = delete;
+  IndexCache& operator=(const IndexCache&) = delete;
+
+  // NOTE: Returns nullptr if the file can not be indexed.
+  FileIndexPtr get(const std::filesystem::path& path);
+
+private:
+  using Entry = std::pair<std::string, FileIndexPtr>;
+
+  void evict();
+
+  std::mutex _mutex;
+  std::size_t _capacity{0};
+  std::size_t _memory{0};
+  std::list<Entry> _lru; // most recently used first
+  std::unordered_map<std::string, std::list<Entry>::iterator> _entries;
+};
+
+struct DaemonOptions {
+  static constexpr std::size_t DEFAULT_CACHE_SIZE = 256 * 1024 * 1024;
+
+  std::size_t cache_size{DEFAULT_CACHE_SIZE};
+  std::size_t num_workers{0}; // 0 := all hardware threads
+};
+
+// NOTE: Serve requests on the Unix socket 'path' until SIGINT or SIGTERM.
+//       Every request is a single line; paths come last and may contain
+//       blanks:
+//
+//         toc <path>
+//         list <path>
+//         extract <id_stream> <FourCC> <from> <to> <path>
+//         read <id_stream> <FourCC> <offset> <length> <path>
+//
+//       'extract' concatenates the payloads of all blocks of the stream with
+//       a time stamp in [from, to]; 'read' reads a byte range of the stream.
+//       Every response is either "OK <size>\n" followed by <size> bytes, or
+//       "ERROR <message>\n". A connection may carry any number of requests;
+//       idle connections do not occupy a worker.
+bool runDaemon(const std::filesystem::path& path, const DaemonOptions& options);
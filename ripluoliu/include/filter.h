@@ -0,0 +1,90 @@
+/****************************************************************************
+** Copyright (c) 2023, Carsten Schmidt. All rights reserved.
+**
+** Redistribution and use in source and binary forms, with or without
+** modification, are permitted provided that the following conditions
+** are met:
+**
+** 1. Redistributions of source code must retain the above copyright
+**    notice, this list of conditions and the following disclaimer.
+**
+** 2. Redistributions in binary form must reproduce the above copyright
+**    notice, this list of conditions and the following disclaimer in the
+**    documentation and/or other materials provided with the distribution.
+**
+** 3. Neither the name of the copyright holder nor the names of its
+**    contributors may be used to endorse or promote products derived from
+**    this software without specific prior written permission.
+**
+** THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+** "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+** LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+** A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+** HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+** SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+** LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+** DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+** THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+** (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+** OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*****************************************************************************/
+
+#pragma once
+
+#include <ctime>
+
+#include <functional>
+#include <limits>
+#include <vector>
+
+#include "sink.h"
+#include "toc.h"
+#include "wrap.h"
+
+// NOTE: The predicates of a filter are compiled against a file's TOC into a
+//       flat table, which routes each matching block to the sink of its
+//       (id_stream, fourcc) with a single lookup per block header.
+//       Empty sets of streams or cameras match any stream or camera.
+
+class Filter {
+public:
+  using SinkFactory = std::function<SinkPtr(const Block::id_stream_t, const FourCC&)>;
+
+  std::vector<FourCC> fourccs;
+  std::vector<Block::id_stream_t> streams;
+  std::vector<Block::id_camera_t> cameras;
+  std::time_t tim_begin{std::numeric_limits<std::time_t>::min()};
+  std::time_t tim_end{std::numeric_limits<std::time_t>::max()};
+  bool is_key_only{false};
+
+  Filter() noexcept;
+
+  bool isEmpty() const;
+
+  void compile(const Toc& toc, const SinkFactory& factory);
+
+  Sink *match(const Block& block) const;
+
+  // NOTE: Evaluate all predicates against the block itself, i.e. without a
+  //       compiled table; an empty set of FourCCs matches any FourCC. As in
+  //       compile(), the camera is the one of the stream's TOC slot.
+  bool accepts(const Block& block, const Toc::id_camera_t id_camera) const;
+
+  void run(const cs::Buffer& buffer, const Wrap& wrap = Wrap()) const;
+
+  void close();
+
+private:
+  using key_t = uint64_t;
+
+  struct Entry {
+    key_t key{};
+    Sink *sink{nullptr};
+    bool is_checking_keys{false};
+  };
+
+  static key_t makeKey(const Block::id_stream_t id_stream, const FourCC& fourcc);
+
+  std::vector<Entry> _table;
+  std::vector<SinkPtr> _sinks;
+};
@@ -0,0 +1,140 @@
+/****************************************************************************
+** Copyright (c) 2023, Carsten Schmidt. All rights reserved.
+**
+** Redistribution and use in source and binary forms, with or without
+** modification, are permitted provided that the following conditions
+** are met:
+**
+** 1. Redistributions of source code must retain the above copyright
+**    notice, this list of conditions and the following disclaimer.
+**
+** 2. Redistributions in binary form must reproduce the above copyright
+**    notice, this list of conditions and the following disclaimer in the
+**    documentation and/or other materials provided with the distribution.
+**
+** 3. Neither the name of the copyright holder nor the names of its
+**    contributors may be used to endorse or promote products derived from
+**    this software without specific prior written permission.
+**
+** THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+** "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+** LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+** A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+** HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+** SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+** LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+** DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+** THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+** (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+** OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*****************************************************************************/
+
+#pragma once
+
+#include <vector>
+
+#include "sink.h"
+
+enum class NalCodec {
+  None,
+  H264,
+  H265
+};
+
+NalCodec nalCodec(const FourCC& fourcc);
+
+// NOTE: Returns the position of the next start code (00 00 01) at or after
+//       'pos'; returns 'size' if there is none.
+std::size_t findStartCode(const cs::byte_t *data, const std::size_t size,
+                          const std::size_t pos = 0);
+
+struct Nal {
+  std::size_t offset{}; // of the NAL header; w/o start code
+  std::size_t size{};   // w/o start code
+  uint8_t type{};
+  bool is_broken{false};
+  bool is_key{false};
+};
+
+// NOTE: Calls 'func(const Nal&)' for every NAL unit of an Annex B byte stream;
+//       offsets are relative to 'data'. Returns the number of NAL units.
+template <typename Func>
+std::size_t scanNals(const NalCodec codec,
+                     const cs::byte_t *data, const std::size_t size,
+                     Func func)
+{
+  std::size_t count = 0;
+  for( std::size_t pos = findStartCode(data, size); pos < size; count++ ) {
+    const std::size_t begin = pos + 3;
+    const std::size_t next  = findStartCode(data, size, begin);
+
+    std::size_t end = next;
+    while( end > begin && next < size && data[end - 1] == 0 ) { // 4 byte start code
+      end--;
+    }
+
+    Nal nal;
+    nal.offset    = begin;
+    nal.size      = end - begin;
+    nal.is_broken = nal.size == 0 || (data[begin] & 0x80) != 0; // forbidden_zero_bit
+    if( !nal.is_broken ) {
+      if( codec == NalCodec::H264 ) {
+        nal.type   = data[begin] & 0x1F;
+        nal.is_key = nal.type == 5;
+      } else if( codec == NalCodec::H265 ) {
+        nal.type   = (data[begin] >> 1) & 0x3F;
+        nal.is_key = nal.type >= 16 && nal.type <= 21; // IRAP
+      }
+    }
+
+    func(nal);
+
+    pos = next;
+  }
+
+  return count;
+}
+
+const char *nalTypeName(const NalCodec codec, const uint8_t type);
+
+// NOTE: Whether a payload holds a key frame according to its NAL unit types;
+//       without NAL units, 'is_key' (i.e. the header's flag) is returned.
+bool hasKeyFrame(const NalCodec codec,
+                 const cs::byte_t *data, const std::size_t size,
+                 const bool is_key);
+
+// NOTE: NalSink scans every payload for NAL units before passing it on to the
+//       wrapped sink. It optionally writes an index "<offset> <size> <type>"
+//       of all NAL units, drops broken NAL units and corrects the key frame
+//       flag of the block from the NAL unit types. If 'key_only', only blocks
+//       holding a key frame according to the corrected flag are passed on.
+
+class NalSink : public Sink {
+public:
+  ~NalSink() noexcept;
+
+  void write(const Block& block,
+             const cs::byte_t *data, const std::size_t size) override;
+  void close() override;
+
+  bool checksKeyFrames() const override;
+
+  static SinkPtr make(SinkPtr sink, const NalCodec codec,
+                      const std::filesystem::path& index, const bool drop_broken,
+                      const bool key_only = false);
+
+private:
+  // NOTE: The NAL units of a block are collected in a vector reused for all
+  //       blocks; it only grows for blocks with more NAL units.
+  static constexpr std::size_t NUM_NALS_RESERVED = 64;
+
+  NalSink() noexcept;
+
+  SinkPtr _sink;
+  NalCodec _codec{NalCodec::None};
+  cs::File _index;
+  bool _drop_broken{false};
+  bool _key_only{false};
+  std::size_t _offset{0};
+  std::vector<Nal> _nals;
+};
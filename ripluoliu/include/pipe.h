@@ -0,0 +1,82 @@
+/****************************************************************************
+** Copyright (c) 2023, Carsten Schmidt. All rights reserved.
+**
+** Redistribution and use in source and binary forms, with or without
+** modification, are permitted provided that the following conditions
+** are met:
+**
+** 1. Redistributions of source code must retain the above copyright
+**    notice, this list of conditions and the following disclaimer.
+**
+** 2. Redistributions in binary form must reproduce the above copyright
+**    notice, this list of conditions and the following disclaimer in the
+**    documentation and/or other materials provided with the distribution.
+**
+** 3. Neither the name of the copyright holder nor the names of its
+**    contributors may be used to endorse or promote products derived from
+**    this software without specific prior written permission.
+**
+** THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+** "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+** LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+** A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+** HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+** SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+** LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+** DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+** THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+** (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+** OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*****************************************************************************/
+
+#pragma once
+
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
+
+#include "sink.h"
+
+// NOTE: PipeSink writes to stdout or to a named FIFO from its own thread;
+//       the FIFO is created if necessary. Payloads are queued without being
+//       copied, i.e. the queue costs no memory beyond the input buffer; hence,
+//       the queue is unbounded and a slow reader never stalls the other
+//       streams. Opening the FIFO does not block the demux. If no reader
+//       opens the FIFO within TIMEOUT_OPEN_S seconds after the sink is
+//       closed, or if the reader goes away, all payloads are discarded.
+//       Closing the sink does not wait for the reader; destroying it does.
+//       Hence, the payloads must stay valid until the sink is destroyed!
+
+class PipeSink : public Sink {
+public:
+  static constexpr int TIMEOUT_OPEN_S = 10;
+
+  ~PipeSink() noexcept;
+
+  void write(const Block& block,
+             const cs::byte_t *data, const std::size_t size) override;
+  void close() override;
+
+  // NOTE: An empty 'fifo' selects stdout.
+  static SinkPtr make(const std::filesystem::path& fifo);
+
+private:
+  struct Span {
+    const cs::byte_t *data{nullptr};
+    std::size_t size{};
+  };
+
+  PipeSink() noexcept;
+
+  int openFifo();
+  void work();
+
+  std::filesystem::path _fifo;
+  std::thread _thread;
+  std::mutex _mutex;
+  std::condition_variable _cond_data;
+  std::deque<Span> _queue;
+  bool _is_closed{false};
+  bool _is_broken{false};
+};
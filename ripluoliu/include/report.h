@@ -0,0 +1,125 @@
+/****************************************************************************
+** Copyright (c) 2023, Carsten Schmidt. All rights reserved.
+**
+** Redistribution and use in source and binary forms, with or without
+** modification, are permitted provided that the following conditions
+** are met:
+**
+** 1. Redistributions of source code must retain the above copyright
+**    notice, this list of conditions and the following disclaimer.
+**
+** 2. Redistributions in binary form must reproduce the above copyright
+**    notice, this list of conditions and the following disclaimer in the
+**    documentation and/or other materials provided with the distribution.
+**
+** 3. Neither the name of the copyright holder nor the names of its
+**    contributors may be used to endorse or promote products derived from
+**    this software without specific prior written permission.
+**
+** THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+** "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+** LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+** A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+** HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+** SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+** LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+** DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+** THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+** (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+** OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*****************************************************************************/
+
+#pragma once
+
+#include <array>
+#include <ostream>
+
+#include "wrap.h"
+
+class BlockFile;
+
+// NOTE: A health report of all streams, computed in a single chain walk with
+//       fixed memory, i.e. without storing anything per block. Bit rate and
+//       frame rate are aggregated over windows of WINDOW seconds, divided by
+//       the seconds actually covered by blocks; a gap is a jump of more than
+//       GAP seconds between consecutive blocks.
+
+class Report {
+public:
+  static constexpr std::size_t MAX_STREAMS = 2 * Toc::NUM_STREAMS;
+  static constexpr std::size_t NUM_BINS    = 33; // log2 of the block size
+  static constexpr std::time_t WINDOW      = 60;
+  static constexpr std::time_t GAP         = 2;
+
+  struct Stream {
+    Block::id_stream_t id_stream{};
+    FourCC fourcc{};
+    Block::id_camera_t id_camera{};
+    Block::vid_fps_t vid_fps{};
+    Block::vid_size_t vid_width{};
+    Block::vid_size_t vid_height{};
+
+    std::size_t num_blocks{0};
+    std::size_t num_keys{0};
+    std::size_t num_bytes{0};
+    std::time_t tim_first{};
+    std::time_t tim_last{};
+
+    // Gaps
+    std::size_t num_gaps{0};
+    std::time_t tim_gaps{0};
+    std::time_t max_gap{0};
+    std::time_t tim_max_gap{};
+
+    // Resolution
+    std::size_t num_resolution_changes{0};
+
+    // Windows
+    std::time_t tim_window{};
+    std::time_t tim_window_last{};
+    std::time_t window_gaps{0};
+    std::size_t window_bytes{0};
+    std::size_t window_blocks{0};
+    std::size_t num_windows{0};
+    double min_bitrate{0};
+    double max_bitrate{0};
+    double min_fps{0};
+    double max_fps{0};
+
+    // Block Size
+    double mean_size{0};
+    double m2_size{0};
+    std::size_t max_size{0};
+    std::size_t num_outliers{0};
+    std::array<std::size_t, NUM_BINS> histogram{};
+
+    void add(const Block& block);
+    void finish();
+
+    std::time_t duration() const; // w/o gaps
+    double bitrate() const;
+    double fps() const;
+    double stddevSize() const;
+
+  private:
+    void closeWindow();
+  };
+
+  Report() noexcept;
+
+  void add(const Block& block);
+  void finish();
+
+  void print(std::ostream *stream) const;
+  void printJson(std::ostream *stream) const;
+
+  static Report run(const cs::Buffer& buffer, const Wrap& wrap = Wrap());
+
+  // NOTE: Only the block headers are read from 'file'.
+  static Report run(BlockFile& file);
+
+private:
+  std::array<Stream, MAX_STREAMS> _streams;
+  std::size_t _num_streams{0};
+  std::size_t _num_ignored{0};
+};
@@ -0,0 +1,125 @@
+/****************************************************************************
+** Copyright (c) 2023, Carsten Schmidt. All rights reserved.
+**
+** Redistribution and use in source and binary forms, with or without
+** modification, are permitted provided that the following conditions
+** are met:
+**
+** 1. Redistributions of source code must retain the above copyright
+**    notice, this list of conditions and the following disclaimer.
+**
+** 2. Redistributions in binary form must reproduce the above copyright
+**    notice, this list of conditions and the following disclaimer in the
+**    documentation and/or other materials provided with the distribution.
+**
+** 3. Neither the name of the copyright holder nor the names of its
+**    contributors may be used to endorse or promote products derived from
+**    this software without specific prior written permission.
+**
+** THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+** "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+** LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+** A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+** HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+** SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+** LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+** DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+** THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+** (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+** OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*****************************************************************************/
+
+#pragma once
+
+#include <ctime>
+
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "sink.h"
+
+struct Segmentation {
+  std::time_t duration{0};
+  std::size_t size{0};
+
+  bool isEnabled() const;
+};
+
+// NOTE: The WriterPool writes finished segments in the background, so writing
+//       and closing files overlaps with parsing. submit() blocks while all
+//       workers are busy and the queue is full.
+
+class WriterPool {
+public:
+  struct Span {
+    const cs::byte_t *data{nullptr};
+    std::size_t size{};
+  };
+
+  struct Job {
+    std::filesystem::path path;
+    std::vector<Span> spans;
+  };
+
+  WriterPool(const std::size_t numThreads = 0) noexcept;
+  ~WriterPool() noexcept;
+
+  WriterPool(const WriterPool&)            = delete;
+  WriterPool& operator=(const WriterPool&) = delete;
+
+  void submit(Job job);
+
+  // NOTE: Returns false if any segment could not be written completely.
+  bool finish();
+
+private:
+  void work();
+
+  std::vector<std::thread> _threads;
+  std::deque<Job> _jobs;
+  std::mutex _mutex;
+  std::condition_variable _cond_jobs;
+  std::condition_variable _cond_space;
+  std::size_t _max_jobs{0};
+  bool _is_finished{false};
+  std::size_t _num_failed{0};
+};
+
+// NOTE: SegmentSink splits a stream into "<stem>-0x<id>-<number>.<fourcc>"
+//       whenever a segment's duration or size is exceeded; the split waits
+//       for the next key frame of streams having key frames.
+//       The payloads are not copied; they must stay valid until the pool
+//       has finished!
+
+class SegmentSink : public Sink {
+public:
+  ~SegmentSink() noexcept;
+
+  void write(const Block& block,
+             const cs::byte_t *data, const std::size_t size) override;
+  void close() override;
+
+  static SinkPtr make(WriterPool *pool, const Segmentation& segmentation,
+                      const std::filesystem::path& input,
+                      const Block::id_stream_t id_stream, const FourCC& fourcc);
+
+private:
+  SegmentSink() noexcept;
+
+  void flush();
+
+  WriterPool *_pool{nullptr};
+  Segmentation _segmentation;
+  std::string _prefix; // "<stem>-0x<id_stream>-"
+  std::string _suffix; // ".<fourcc>"
+  std::size_t _number{0};
+  bool _has_keys{false};
+  std::time_t _tim_begin{};
+  std::size_t _size{0};
+  std::size_t _offset{0};
+  WriterPool::Job _job;
+};
@@ -0,0 +1,80 @@
+/****************************************************************************
+** Copyright (c) 2023, Carsten Schmidt. All rights reserved.
+**
+** Redistribution and use in source and binary forms, with or without
+** modification, are permitted provided that the following conditions
+** are met:
+**
+** 1. Redistributions of source code must retain the above copyright
+**    notice, this list of conditions and the following disclaimer.
+**
+** 2. Redistributions in binary form must reproduce the above copyright
+**    notice, this list of conditions and the following disclaimer in the
+**    documentation and/or other materials provided with the distribution.
+**
+** 3. Neither the name of the copyright holder nor the names of its
+**    contributors may be used to endorse or promote products derived from
+**    this software without specific prior written permission.
+**
+** THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+** "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+** LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+** A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+** HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+** SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+** LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+** DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+** THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+** (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+** OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*****************************************************************************/
+
+#pragma once
+
+#include <filesystem>
+#include <memory>
+
+#include <cs/IO/File.h>
+
+#include "block.h"
+
+// NOTE: A sink receives the payloads of all blocks routed to it.
+
+class Sink {
+public:
+  virtual ~Sink() noexcept;
+
+  // NOTE: 'data' holds (a part of) the payload of 'block'.
+  virtual void write(const Block& block,
+                     const cs::byte_t *data, const std::size_t size) = 0;
+  virtual void close();
+
+  // NOTE: A sink determining key frames itself (cf. NalSink) receives all
+  //       blocks of a key-only filter.
+  virtual bool checksKeyFrames() const;
+
+protected:
+  Sink() noexcept;
+};
+
+using SinkPtr = std::unique_ptr<Sink>;
+
+class FileSink : public Sink {
+public:
+  ~FileSink() noexcept;
+
+  void write(const Block& block,
+             const cs::byte_t *data, const std::size_t size) override;
+  void close() override;
+
+  static SinkPtr make(const std::filesystem::path& path);
+
+private:
+  FileSink() noexcept;
+
+  cs::File _file;
+};
+
+// NOTE: "<stem>-0x<id_stream>.<fourcc>"
+std::filesystem::path outputPath(const std::filesystem::path& input,
+                                 const Block::id_stream_t id_stream, const FourCC& fourcc);
@@ -0,0 +1,74 @@
+/****************************************************************************
+** Copyright (c) 2023, Carsten Schmidt. All rights reserved.
+**
+** Redistribution and use in source and binary forms, with or without
+** modification, are permitted provided that the following conditions
+** are met:
+**
+** 1. Redistributions of source code must retain the above copyright
+**    notice, this list of conditions and the following disclaimer.
+**
+** 2. Redistributions in binary form must reproduce the above copyright
+**    notice, this list of conditions and the following disclaimer in the
+**    documentation and/or other materials provided with the distribution.
+**
+** 3. Neither the name of the copyright holder nor the names of its
+**    contributors may be used to endorse or promote products derived from
+**    this software without specific prior written permission.
+**
+** THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+** "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+** LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+** A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+** HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+** SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+** LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+** DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+** THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+** (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+** OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*****************************************************************************/
+
+#pragma once
+
+#include <ostream>
+#include <vector>
+
+#include "blockfile.h"
+
+// NOTE: Map the offsets of a virtual, contiguous stream (i.e. the output of
+//       an extraction, in chronological order) to the payloads of the blocks
+//       in the source file.
+
+class StreamMap {
+public:
+  struct Span {
+    uint64_t offset{}; // virtual
+    uint64_t data{};   // source
+    uint32_t size{};
+  };
+
+  StreamMap() noexcept;
+
+  bool isEmpty() const;
+  std::size_t size() const;
+
+  const std::vector<Span>& spans() const;
+
+  void clear();
+  void add(const Block& block);
+
+  // NOTE: Returns the number of bytes read; less than 'size' at the end of
+  //       the stream or upon error.
+  std::size_t read(const BlockFile& file, const std::size_t offset,
+                   void *data, const std::size_t size) const;
+
+  void print(std::ostream *stream) const;
+
+  static StreamMap build(BlockFile& file,
+                         const Block::id_stream_t id_stream, const FourCC& fourcc);
+
+private:
+  std::vector<Span> _spans;
+  std::size_t _size{0};
+};
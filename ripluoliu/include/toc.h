@@ -48,18 +48,27 @@ struct Toc {
 
   std::time_t tim_begin{};
   std::time_t tim_end{};
-  std::array<id_stream_t, NUM_STREAMS> id_stream;
-  std::array<id_camera_t, NUM_STREAMS> id_camera;
-  std::array<num_blocks_t, NUM_STREAMS> num_blocks;
-  std::array<siz_stream_t, NUM_STREAMS> siz_stream;
-  std::array<std::time_t, NUM_STREAMS> tim_stream_begin;
-  std::array<std::time_t, NUM_STREAMS> tim_stream_end1;
-  std::array<std::time_t, NUM_STREAMS> tim_stream_end2;
+  std::array<id_stream_t, NUM_STREAMS> id_stream{};
+  std::array<id_camera_t, NUM_STREAMS> id_camera{};
+  std::array<num_blocks_t, NUM_STREAMS> num_blocks{};
+  std::array<siz_stream_t, NUM_STREAMS> siz_stream{};
+  std::array<std::time_t, NUM_STREAMS> tim_stream_begin{};
+  std::array<std::time_t, NUM_STREAMS> tim_stream_end1{};
+  std::array<std::time_t, NUM_STREAMS> tim_stream_end2{};
 
   Toc() noexcept;
 
+  bool isValid() const;
+
   void print(std::ostream *stream) const;
   void print() const;
 
+  // NOTE: Only the known fields and the tags are written; all other bytes
+  //       of 'buffer' are kept.
+  bool write(cs::Buffer& buffer, const std::size_t offset = 0) const;
+
   static Toc read(const cs::Buffer& buffer, const std::size_t offset = 0);
+
+private:
+  bool _is_valid{false};
 };
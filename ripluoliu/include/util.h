@@ -33,7 +33,15 @@
 
 #include <ctime>
 
+#include <algorithm>
+#include <atomic>
+#include <charconv>
+#include <filesystem>
+#include <functional>
 #include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
 
 #include <cs/Convert/Deserialize.h>
 
@@ -44,4 +52,63 @@ inline T readInt(const cs::byte_t *data, const std::size_t offset,
   return cs::toIntegralFromLE<T>(data + offset + displacement * sizeof(T), sizeof(T));
 }
 
+template <typename T>
+inline void writeInt(cs::byte_t *data, const std::size_t offset, const T value,
+                     const std::size_t displacement = 0)
+{
+  for( std::size_t i = 0; i < sizeof(T); i++ ) {
+    data[offset + displacement * sizeof(T) + i] = static_cast<cs::byte_t>(value >> (i * 8));
+  }
+}
+
+// NOTE: Parse a decimal or a hexadecimal (prefix "0x") integer.
+template <typename T>
+inline bool parseInt(const std::string_view s, T *value)
+{
+  const bool is_hex    = s.size() > 2 && s[0] == '0' && (s[1] == 'x' || s[1] == 'X');
+  const char *first    = s.data() + (is_hex ? 2 : 0);
+  const char *last     = s.data() + s.size();
+  const auto [ptr, ec] = std::from_chars(first, last, *value, is_hex ? 16 : 10);
+  return !s.empty() && ec == std::errc() && ptr == last;
+}
+
+// NOTE: Call 'func(i)' for every i in [0, count) on all hardware threads.
+template <typename Func>
+void parallelFor(const std::size_t count, Func func)
+{
+  const std::size_t numThreads = std::min<std::size_t>(std::max(std::thread::hardware_concurrency(), 1u),
+                                                       count);
+
+  std::atomic<std::size_t> next{0};
+  const auto worker = [&]() -> void {
+    for( std::size_t i = next++; i < count; i = next++ ) {
+      func(i);
+    }
+  };
+
+  std::vector<std::thread> threads;
+  for( std::size_t i = 0; i < numThreads; i++ ) {
+    threads.emplace_back(worker);
+  }
+  for( std::thread& thread : threads ) {
+    thread.join();
+  }
+}
+
+// NOTE: Call 'func(entry)' for all entries below 'root' except directories;
+//       unreadable directories are reported on stderr and skipped. Returns
+//       false if 'root' itself can not be scanned.
+using WalkFunc = std::function<void(const std::filesystem::directory_entry&)>;
+
+bool walkDirectory(const std::filesystem::path& root, const WalkFunc& func);
+
+// NOTE: Parse a size with an optional suffix 'K', 'M' or 'G' (base 1024).
+bool parseSize(const std::string_view s, std::size_t *size);
+
+// NOTE: Parse a duration with an optional suffix 's', 'm' or 'h'.
+bool parseDuration(const std::string_view s, std::time_t *duration);
+
 std::string formatTime(const std::time_t t);
+
+// NOTE: Parse either the output of formatTime() (UTC) or seconds since epoch.
+bool parseTime(const std::string_view s, std::time_t *t);
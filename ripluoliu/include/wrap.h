@@ -0,0 +1,134 @@
+/****************************************************************************
+** Copyright (c) 2023, Carsten Schmidt. All rights reserved.
+**
+** Redistribution and use in source and binary forms, with or without
+** modification, are permitted provided that the following conditions
+** are met:
+**
+** 1. Redistributions of source code must retain the above copyright
+**    notice, this list of conditions and the following disclaimer.
+**
+** 2. Redistributions in binary form must reproduce the above copyright
+**    notice, this list of conditions and the following disclaimer in the
+**    documentation and/or other materials provided with the distribution.
+**
+** 3. Neither the name of the copyright holder nor the names of its
+**    contributors may be used to endorse or promote products derived from
+**    this software without specific prior written permission.
+**
+** THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+** "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+** LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+** A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+** HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+** SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+** LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+** DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+** THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+** (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+** OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*****************************************************************************/
+
+#pragma once
+
+#include <ctime>
+
+#include "block.h"
+#include "toc.h"
+
+class BlockFile;
+
+// NOTE: Files written as ring buffers hold the newest blocks in
+//       [Toc::SIZE_TOC, end) and the oldest blocks in [begin, EOF);
+//       begin == end if the block chain continues across the wrap point.
+
+struct Wrap {
+  std::size_t begin{0};
+  std::size_t end{0};
+
+  bool isWrapped() const;
+
+  void print(std::ostream *stream) const;
+  void print() const;
+
+  // NOTE: The wrap point is located by sampling block timestamps at evenly
+  //       spaced offsets, followed by a bisection and a short chain walk;
+  //       a drop of more than 'threshold' seconds is considered a wrap,
+  //       unless the blocks at EOF are newer than the first block.
+  static Wrap find(const cs::Buffer& buffer, const std::time_t threshold = 5);
+  static Wrap find(BlockFile& file, const std::time_t threshold = 5);
+};
+
+// NOTE: Blocks of a file held in memory; cf. BlockFile for the same interface
+//       reading only the block headers of a file.
+
+struct BufferReader {
+  const cs::Buffer& buffer;
+
+  std::size_t size() const;
+
+  Block readBlock(const std::size_t offset) const;
+
+  // NOTE: Find the first block at or after 'pos' whose successor is a valid
+  //       block, too (or which is the last block of the buffer).
+  Block resync(const std::size_t pos) const;
+};
+
+// NOTE: Chronological iteration, i.e. the oldest blocks first: the blocks of
+//       [wrap.begin, EOF) are followed by the blocks of [Toc::SIZE_TOC,
+//       wrap.end). A broken block chain is resynchronized at the next valid
+//       block instead of ending the iteration.
+
+template <typename Reader>
+Block firstBlock(Reader& reader, const Wrap& wrap)
+{
+  const std::size_t offset = wrap.isWrapped()
+                             ? wrap.begin
+                             : Toc::SIZE_TOC;
+
+  const Block block = reader.readBlock(offset);
+  return block.isValid()
+         ? block
+         : reader.resync(offset);
+}
+
+template <typename Reader>
+Block nextBlock(Reader& reader, const Wrap& wrap, const Block& block)
+{
+  Block next = reader.readBlock(block.next());
+  if( !next.isValid() && block.next() + Block::SIZE_BLOCK_HEADER <= reader.size() ) {
+    next = reader.resync(block.next());
+  }
+
+  if( !wrap.isWrapped() ) {
+    return next;
+  }
+
+  // (1) Oldest Blocks; continue with the newest blocks at EOF.
+  if( block.offset >= wrap.begin ) {
+    if( next.isValid() ) {
+      return next;
+    }
+
+    next = reader.readBlock(Toc::SIZE_TOC);
+    if( !next.isValid() ) {
+      next = reader.resync(Toc::SIZE_TOC);
+    }
+  }
+
+  // (2) Newest Blocks; end at the wrap point.
+  return next.isValid() && next.offset < wrap.end
+         ? next
+         : Block();
+}
+
+// NOTE: Call 'func(const Block&)' for all blocks in chronological order.
+template <typename Reader, typename Func>
+void forEachBlock(Reader& reader, const Wrap& wrap, Func func)
+{
+  for( Block block = firstBlock(reader, wrap);
+       block.isValid();
+       block = nextBlock(reader, wrap, block) ) {
+    func(block);
+  }
+}
@@ -44,7 +44,7 @@ namespace impl_block {
   {
     return x == std::numeric_limits<uint32_t>::max()
            ? cs::sprint("0x%", cs::hexf(x, true))
-           : cs::sprint("%", x);
+           : std::to_string(x);
   }
 
 } // namespace impl_block
@@ -79,6 +79,7 @@ void Block::print(std::ostream *stream) const
   cs::println(stream, "vid_fps    = %", impl_block::formatUInt32(vid_fps));
   cs::println(stream, "aud_rate   = %", impl_block::formatUInt32(aud_rate));
   cs::println(stream, "fourcc     = %", toStringView(fourcc));
+  cs::println(stream, "is_key     = %", is_key ? 1 : 0);
   cs::println(stream, "id_camera  = %", id_camera);
   cs::println(stream, "block_size = %", block_size);
   cs::println(stream, "timestamp  = %", formatTime(timestamp));
@@ -94,16 +95,6 @@ void Block::print() const
 
 Block Block::read(const cs::Buffer& buffer, const std::size_t offset)
 {
-  constexpr std::size_t OFFS_ID_STREAM  = 0x04;
-  constexpr std::size_t OFFS_VID_WIDTH  = 0x08;
-  constexpr std::size_t OFFS_VID_HEIGHT = 0x0C;
-  constexpr std::size_t OFFS_VID_FPS    = 0x10;
-  constexpr std::size_t OFFS_AUD_RATE   = 0x14;
-  constexpr std::size_t OFFS_FOURCC     = 0x18;
-  constexpr std::size_t OFFS_ID_CAMERA  = 0x28;
-  constexpr std::size_t OFFS_BLOCK_SIZE = 0x3C;
-  constexpr std::size_t OFFS_TIMESTAMP  = 0x48;
-
   // Result //////////////////////////////////////////////////////////////////
 
   Block block(buffer, offset);
@@ -111,25 +102,33 @@ Block Block::read(const cs::Buffer& buffer, const std::size_t offset)
     return Block();
   }
 
-  // Helper //////////////////////////////////////////////////////////////////
+  block.parse(buffer, offset);
 
-  const cs::byte_t *data = buffer.data() + offset;
+  // Final Sanity Check //////////////////////////////////////////////////////
 
-  // Read Header /////////////////////////////////////////////////////////////
+  if( block.next() > buffer.size() ) {
+    return Block();
+  }
 
-  block.id_stream  = readInt<id_stream_t>(data, OFFS_ID_STREAM);
-  block.vid_width  = readInt<vid_size_t>(data, OFFS_VID_WIDTH);
-  block.vid_height = readInt<vid_size_t>(data, OFFS_VID_HEIGHT);
-  block.vid_fps    = readInt<vid_fps_t>(data, OFFS_VID_FPS);
-  block.aud_rate   = readInt<aud_rate_t>(data, OFFS_AUD_RATE);
-  block.fourcc     = getFourCC_nc(buffer, offset + OFFS_FOURCC);
-  block.id_camera  = readInt<id_camera_t>(data, OFFS_ID_CAMERA);
-  block.block_size = readInt<block_size_t>(data, OFFS_BLOCK_SIZE);
-  block.timestamp  = readInt<timestamp_t>(data, OFFS_TIMESTAMP);
+  return block;
+}
+
+Block Block::readHeader(const cs::Buffer& header,
+                        const std::size_t offset, const std::size_t size)
+{
+  // Result //////////////////////////////////////////////////////////////////
+
+  Block block(header, 0);
+  if( !block.isValid() ) {
+    return Block();
+  }
+
+  block.parse(header, 0);
+  block.offset = offset;
 
   // Final Sanity Check //////////////////////////////////////////////////////
 
-  if( block.next() > buffer.size() ) {
+  if( block.next() > size ) {
     return Block();
   }
 
@@ -158,3 +157,34 @@ Block::Block(const cs::Buffer& buffer, const std::size_t offsBuffer) noexcept
   offset    = offsBuffer;
   _is_valid = true;
 }
+
+void Block::parse(const cs::Buffer& buffer, const std::size_t offsBuffer)
+{
+  constexpr std::size_t OFFS_ID_STREAM  = 0x04;
+  constexpr std::size_t OFFS_VID_WIDTH  = 0x08;
+  constexpr std::size_t OFFS_VID_HEIGHT = 0x0C;
+  constexpr std::size_t OFFS_VID_FPS    = 0x10;
+  constexpr std::size_t OFFS_AUD_RATE   = 0x14;
+  constexpr std::size_t OFFS_FOURCC     = 0x18;
+  constexpr std::size_t OFFS_IS_KEY     = 0x24;
+  constexpr std::size_t OFFS_ID_CAMERA  = 0x28;
+  constexpr std::size_t OFFS_BLOCK_SIZE = 0x3C;
+  constexpr std::size_t OFFS_TIMESTAMP  = 0x48;
+
+  // Helper //////////////////////////////////////////////////////////////////
+
+  const cs::byte_t *data = buffer.data() + offsBuffer;
+
+  // Read Header /////////////////////////////////////////////////////////////
+
+  id_stream  = readInt<id_stream_t>(data, OFFS_ID_STREAM);
+  vid_width  = readInt<vid_size_t>(data, OFFS_VID_WIDTH);
+  vid_height = readInt<vid_size_t>(data, OFFS_VID_HEIGHT);
+  vid_fps    = readInt<vid_fps_t>(data, OFFS_VID_FPS);
+  aud_rate   = readInt<aud_rate_t>(data, OFFS_AUD_RATE);
+  fourcc     = getFourCC_nc(buffer, offsBuffer + OFFS_FOURCC);
+  is_key     = readInt<is_key_t>(data, OFFS_IS_KEY) == 1;
+  id_camera  = readInt<id_camera_t>(data, OFFS_ID_CAMERA);
+  block_size = readInt<block_size_t>(data, OFFS_BLOCK_SIZE);
+  timestamp  = readInt<timestamp_t>(data, OFFS_TIMESTAMP);
+}
@@ -0,0 +1,165 @@
+/****************************************************************************
+** Copyright (c) 2023, Carsten Schmidt. All rights reserved.
+**
+** Redistribution and use in source and binary forms, with or without
+** modification, are permitted provided that the following conditions
+** are met:
+**
+** 1. Redistributions of source code must retain the above copyright
+**    notice, this list of conditions and the following disclaimer.
+**
+** 2. Redistributions in binary form must reproduce the above copyright
+**    notice, this list of conditions and the following disclaimer in the
+**    documentation and/or other materials provided with the distribution.
+**
+** 3. Neither the name of the copyright holder nor the names of its
+**    contributors may be used to endorse or promote products derived from
+**    this software without specific prior written permission.
+**
+** THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+** "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+** LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+** A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+** HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+** SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+** LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+** DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+** THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+** (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+** OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*****************************************************************************/
+
+#include <algorithm>
+
+#include "blockfile.h"
+
+////// public ////////////////////////////////////////////////////////////////
+
+BlockFile::BlockFile() noexcept
+{
+}
+
+bool BlockFile::open(const std::filesystem::path& path)
+{
+  _path.clear();
+  _size = 0;
+  _wrap = Wrap();
+
+  if( !_file.open(path) ) {
+    return false;
+  }
+
+  _path = path;
+  _size = _file.size();
+
+  return true;
+}
+
+bool BlockFile::isOpen() const
+{
+  return _file.isOpen();
+}
+
+const std::filesystem::path& BlockFile::path() const
+{
+  return _path;
+}
+
+std::size_t BlockFile::size() const
+{
+  return _size;
+}
+
+std::size_t BlockFile::read(const std::size_t offset, void *data, const std::size_t size) const
+{
+  if( offset + size > _size || !_file.seek(offset) ) {
+    return 0;
+  }
+
+  return _file.read(data, size);
+}
+
+Toc BlockFile::readToc() const
+{
+  cs::Buffer buffer(Toc::SIZE_TOC);
+  if( read(0, buffer.data(), buffer.size()) != buffer.size() ) {
+    return Toc();
+  }
+
+  return Toc::read(buffer);
+}
+
+Block BlockFile::readBlock(const std::size_t offset)
+{
+  _header.resize(Block::SIZE_BLOCK_HEADER);
+  if( read(offset, _header.data(), _header.size()) != _header.size() ) {
+    return Block();
+  }
+
+  return Block::readHeader(_header, offset, _size);
+}
+
+Block BlockFile::resync(const std::size_t pos)
+{
+  constexpr std::size_t SIZE_CHUNK  = 0x10000;
+  constexpr cs::byte_t TAG_BEGIN[4] = {'l', 'i', 'u', ' '};
+
+  // NOTE: Chunks overlap by the size of the tag minus one; a tag beginning
+  //       in the overlap is found again in the next chunk.
+  cs::Buffer chunk;
+  for( std::size_t base = pos; base < _size; base += SIZE_CHUNK ) {
+    chunk.resize(std::min(SIZE_CHUNK + sizeof(TAG_BEGIN) - 1, _size - base));
+    if( read(base, chunk.data(), chunk.size()) != chunk.size() ) {
+      return Block();
+    }
+
+    for( auto it = chunk.begin();
+         (it = std::search(it, chunk.end(), TAG_BEGIN, TAG_BEGIN + 4)) != chunk.end();
+         ++it ) {
+      const std::size_t offset = base + (it - chunk.begin());
+      if( offset >= base + SIZE_CHUNK ) {
+        break;
+      }
+
+      const Block block = readBlock(offset);
+      if( !block.isValid() ) {
+        continue;
+      }
+
+      if( block.next() + Block::SIZE_BLOCK_HEADER > _size
+          || readBlock(block.next()).isValid() ) {
+        return block;
+      }
+    }
+  }
+
+  return Block();
+}
+
+const Wrap& BlockFile::findWrap(const std::time_t threshold)
+{
+  _wrap = Wrap();
+  _wrap = Wrap::find(*this, threshold);
+  return _wrap;
+}
+
+const Wrap& BlockFile::wrap() const
+{
+  return _wrap;
+}
+
+Block BlockFile::first()
+{
+  return firstBlock(*this, _wrap);
+}
+
+Block BlockFile::next(const Block& block)
+{
+  return nextBlock(*this, _wrap, block);
+}
+
+bool BlockFile::readData(const Block& block, cs::Buffer& data) const
+{
+  data.resize(block.block_size);
+  return read(block.data(), data.data(), data.size()) == data.size();
+}
@@ -0,0 +1,564 @@
+/****************************************************************************
+** Copyright (c) 2023, Carsten Schmidt. All rights reserved.
+**
+** Redistribution and use in source and binary forms, with or without
+** modification, are permitted provided that the following conditions
+** are met:
+**
+** 1. Redistributions of source code must retain the above copyright
+**    notice, this list of conditions and the following disclaimer.
+**
+** 2. Redistributions in binary form must reproduce the above copyright
+**    notice, this list of conditions and the following disclaimer in the
+**    documentation and/or other materials provided with the distribution.
+**
+** 3. Neither the name of the copyright holder nor the names of its
+**    contributors may be used to endorse or promote products derived from
+**    this software without specific prior written permission.
+**
+** THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+** "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+** LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+** A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+** HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+** SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+** LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+** DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+** THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+** (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+** OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*****************************************************************************/
+
+#include <cstdio>
+
+#include <algorithm>
+#include <unordered_map>
+
+#include <cs/IO/File.h>
+#include <cs/Text/PrintFormat.h>
+#include <cs/Text/PrintUtil.h>
+
+#include "catalog.h"
+
+#include "blockfile.h"
+#include "fourcc.h"
+#include "util.h"
+
+////// Private ///////////////////////////////////////////////////////////////
+
+namespace impl_catalog {
+
+  constexpr FourCC   TAG_CATALOG{'l', 'u', 'o', 'c'};
+  constexpr uint32_t VERSION = 2;
+
+  // NOTE: Header, intervals (sorted), offsets of the files, files.
+  constexpr std::size_t SIZE_HEADER   = 0x10;
+  constexpr std::size_t SIZE_INTERVAL = 0x18;
+  constexpr std::size_t SIZE_OFFSET   = 0x08;
+  constexpr std::size_t SIZE_FILE     = 0x1C; // w/o path
+
+  struct Scan {
+    std::filesystem::path path;
+    Catalog::mtime_t mtime{};
+    uint64_t size{};
+    Toc toc;
+  };
+
+  Catalog::mtime_t modificationTime(const std::filesystem::directory_entry& entry)
+  {
+    std::error_code ec;
+    const auto t = entry.last_write_time(ec);
+    return ec
+           ? 0
+           : static_cast<Catalog::mtime_t>(t.time_since_epoch().count());
+  }
+
+  void readTocs(std::vector<Scan>& scans)
+  {
+    parallelFor(scans.size(), [&](const std::size_t i) -> void {
+      BlockFile file;
+      if( file.open(scans[i].path) ) {
+        scans[i].toc = file.readToc();
+      }
+    });
+  }
+
+  bool readHeader(const cs::byte_t *data, std::size_t *numFiles, std::size_t *numIntervals)
+  {
+    if( !std::equal(TAG_CATALOG.begin(), TAG_CATALOG.end(), data)
+        || readInt<uint32_t>(data, 0x4) != VERSION ) {
+      return false;
+    }
+
+    *numFiles     = readInt<uint32_t>(data, 0x8);
+    *numIntervals = readInt<uint32_t>(data, 0xC);
+
+    return true;
+  }
+
+  void readInterval(const cs::byte_t *data, Catalog::Interval *interval)
+  {
+    interval->id_camera = readInt<Toc::id_camera_t>(data, 0x00);
+    interval->id_stream = readInt<Toc::id_stream_t>(data, 0x04);
+    interval->id_file   = readInt<uint32_t>(data, 0x08);
+    interval->tim_begin = readInt<Toc::timestamp_t>(data, 0x0C);
+    interval->tim_end   = readInt<Toc::timestamp_t>(data, 0x10);
+    interval->max_end   = readInt<Toc::timestamp_t>(data, 0x14);
+  }
+
+  void writeInterval(cs::byte_t *data, const Catalog::Interval& interval)
+  {
+    writeInt<Toc::id_camera_t>(data, 0x00, interval.id_camera);
+    writeInt<Toc::id_stream_t>(data, 0x04, interval.id_stream);
+    writeInt<uint32_t>(data, 0x08, interval.id_file);
+    writeInt<Toc::timestamp_t>(data, 0x0C, static_cast<Toc::timestamp_t>(interval.tim_begin));
+    writeInt<Toc::timestamp_t>(data, 0x10, static_cast<Toc::timestamp_t>(interval.tim_end));
+    writeInt<Toc::timestamp_t>(data, 0x14, static_cast<Toc::timestamp_t>(interval.max_end));
+  }
+
+  // NOTE: Returns the length of the path following the record.
+  std::size_t readFile(const cs::byte_t *data, Catalog::File *f)
+  {
+    f->mtime     = readInt<int64_t>(data, 0x00);
+    f->size      = readInt<uint64_t>(data, 0x08);
+    f->tim_begin = readInt<Toc::timestamp_t>(data, 0x10);
+    f->tim_end   = readInt<Toc::timestamp_t>(data, 0x14);
+    return readInt<uint32_t>(data, 0x18);
+  }
+
+  // NOTE: Order of intervals, i.e. by (id_camera, tim_begin).
+  bool isBefore(const Toc::id_camera_t id_camera, const std::time_t t,
+                const Catalog::Interval& interval)
+  {
+    return id_camera != interval.id_camera
+           ? id_camera < interval.id_camera
+           : t < interval.tim_begin;
+  }
+
+} // namespace impl_catalog
+
+////// public ////////////////////////////////////////////////////////////////
+
+Catalog::Catalog() noexcept
+{
+}
+
+std::size_t Catalog::numFiles() const
+{
+  return _files.size();
+}
+
+std::size_t Catalog::numIntervals() const
+{
+  return _intervals.size();
+}
+
+const Catalog::File& Catalog::file(const std::size_t id_file) const
+{
+  return _files[id_file];
+}
+
+bool Catalog::load(const std::filesystem::path& path)
+{
+  using namespace impl_catalog;
+
+  _files.clear();
+  _intervals.clear();
+
+  cs::File file;
+  if( !file.open(path) ) {
+    return false;
+  }
+
+  const cs::Buffer buffer = file.readAll();
+
+  // (1) Header //////////////////////////////////////////////////////////////
+
+  std::size_t numFiles     = 0;
+  std::size_t numIntervals = 0;
+  if( buffer.size() < SIZE_HEADER
+      || !readHeader(buffer.data(), &numFiles, &numIntervals) ) {
+    return false;
+  }
+
+  const cs::byte_t *data       = buffer.data();
+  const std::size_t offsFiles  = SIZE_HEADER + numIntervals * SIZE_INTERVAL;
+  const std::size_t offsRecord = offsFiles + numFiles * SIZE_OFFSET;
+  if( offsRecord > buffer.size() ) {
+    return false;
+  }
+
+  // (2) Intervals ///////////////////////////////////////////////////////////
+
+  // NOTE: Saved sorted and with max_end; cf. index().
+  _intervals.resize(numIntervals);
+  for( std::size_t i = 0; i < numIntervals; i++ ) {
+    readInterval(data + SIZE_HEADER + i * SIZE_INTERVAL, &_intervals[i]);
+
+    if( _intervals[i].id_file >= numFiles ) {
+      _intervals.clear();
+      return false;
+    }
+  }
+
+  // (3) Files ///////////////////////////////////////////////////////////////
+
+  std::size_t pos = offsRecord;
+  for( std::size_t i = 0; i < numFiles; i++ ) {
+    if( readInt<uint64_t>(data, offsFiles + i * SIZE_OFFSET) != pos
+        || pos + SIZE_FILE > buffer.size() ) {
+      _files.clear();
+      _intervals.clear();
+      return false;
+    }
+
+    File f;
+    const std::size_t lenPath = readFile(data + pos, &f);
+    pos += SIZE_FILE;
+    if( pos + lenPath > buffer.size() ) {
+      _files.clear();
+      _intervals.clear();
+      return false;
+    }
+
+    f.path.assign(reinterpret_cast<const char *>(data + pos), lenPath);
+    pos += lenPath;
+
+    _files.push_back(std::move(f));
+  }
+
+  return true;
+}
+
+bool Catalog::load(const std::filesystem::path& path,
+                   const Toc::id_camera_t id_camera, const std::time_t t)
+{
+  using namespace impl_catalog;
+
+  _files.clear();
+  _intervals.clear();
+
+  cs::File file;
+  if( !file.open(path) ) {
+    return false;
+  }
+
+  const auto readAt = [&](const std::size_t offset, void *data, const std::size_t size) -> bool {
+    return file.seek(offset) && file.read(data, size) == size;
+  };
+
+  // (1) Header //////////////////////////////////////////////////////////////
+
+  cs::byte_t header[SIZE_HEADER];
+  std::size_t numFiles     = 0;
+  std::size_t numIntervals = 0;
+  if( !readAt(0, header, sizeof(header))
+      || !readHeader(header, &numFiles, &numIntervals) ) {
+    return false;
+  }
+
+  const std::size_t offsFiles = SIZE_HEADER + numIntervals * SIZE_INTERVAL;
+  if( offsFiles + numFiles * SIZE_OFFSET > file.size() ) {
+    return false;
+  }
+
+  const auto intervalAt = [&](const std::size_t i, Interval *interval) -> bool {
+    cs::byte_t record[SIZE_INTERVAL];
+    if( !readAt(SIZE_HEADER + i * SIZE_INTERVAL, record, sizeof(record)) ) {
+      return false;
+    }
+    readInterval(record, interval);
+    return interval->id_file < numFiles;
+  };
+
+  // (2) Search Intervals ////////////////////////////////////////////////////
+
+  // NOTE: cf. query(); the intervals are searched without reading them all.
+  std::size_t lo = 0;
+  std::size_t hi = numIntervals;
+  while( lo < hi ) {
+    const std::size_t mid = lo + (hi - lo) / 2;
+
+    Interval interval;
+    if( !intervalAt(mid, &interval) ) {
+      return false;
+    }
+
+    if( isBefore(id_camera, t, interval) ) {
+      hi = mid;
+    } else {
+      lo = mid + 1;
+    }
+  }
+
+  for( std::size_t i = lo; i > 0; i-- ) {
+    Interval interval;
+    if( !intervalAt(i - 1, &interval) ) {
+      _intervals.clear();
+      return false;
+    }
+
+    if( interval.id_camera != id_camera || interval.max_end < t ) {
+      break;
+    }
+
+    if( interval.tim_end >= t ) {
+      _intervals.push_back(interval);
+    }
+  }
+
+  std::reverse(_intervals.begin(), _intervals.end());
+
+  // (3) Resolve Files ///////////////////////////////////////////////////////
+
+  std::unordered_map<uint32_t, uint32_t> ids; // id_file -> index of _files
+  for( Interval& interval : _intervals ) {
+    const auto [hit, is_new] = ids.emplace(interval.id_file, static_cast<uint32_t>(_files.size()));
+    interval.id_file         = hit->second;
+    if( !is_new ) {
+      continue;
+    }
+
+    cs::byte_t offset[SIZE_OFFSET];
+    cs::byte_t record[SIZE_FILE];
+    if( !readAt(offsFiles + hit->first * SIZE_OFFSET, offset, sizeof(offset)) ) {
+      _intervals.clear();
+      _files.clear();
+      return false;
+    }
+
+    const std::size_t pos = readInt<uint64_t>(offset, 0);
+    if( !readAt(pos, record, sizeof(record)) ) {
+      _intervals.clear();
+      _files.clear();
+      return false;
+    }
+
+    File f;
+    f.path.resize(readFile(record, &f));
+    if( !readAt(pos + SIZE_FILE, f.path.data(), f.path.size()) ) {
+      _intervals.clear();
+      _files.clear();
+      return false;
+    }
+
+    _files.push_back(std::move(f));
+  }
+
+  return true;
+}
+
+bool Catalog::save(const std::filesystem::path& path) const
+{
+  using namespace impl_catalog;
+
+  const std::size_t offsFiles  = SIZE_HEADER + _intervals.size() * SIZE_INTERVAL;
+  const std::size_t offsRecord = offsFiles + _files.size() * SIZE_OFFSET;
+
+  std::size_t size = offsRecord;
+  for( const File& f : _files ) {
+    size += SIZE_FILE + f.path.size();
+  }
+
+  cs::Buffer buffer(size);
+  cs::byte_t *data = buffer.data();
+
+  // (1) Header //////////////////////////////////////////////////////////////
+
+  std::copy(TAG_CATALOG.begin(), TAG_CATALOG.end(), data);
+  writeInt<uint32_t>(data, 0x4, VERSION);
+  writeInt<uint32_t>(data, 0x8, static_cast<uint32_t>(_files.size()));
+  writeInt<uint32_t>(data, 0xC, static_cast<uint32_t>(_intervals.size()));
+
+  // (2) Intervals ///////////////////////////////////////////////////////////
+
+  for( std::size_t i = 0; i < _intervals.size(); i++ ) {
+    writeInterval(data + SIZE_HEADER + i * SIZE_INTERVAL, _intervals[i]);
+  }
+
+  // (3) Files ///////////////////////////////////////////////////////////////
+
+  std::size_t pos = offsRecord;
+  for( std::size_t i = 0; i < _files.size(); i++ ) {
+    const File& f = _files[i];
+
+    writeInt<uint64_t>(data, offsFiles + i * SIZE_OFFSET, pos);
+
+    writeInt<int64_t>(data, pos + 0x00, f.mtime);
+    writeInt<uint64_t>(data, pos + 0x08, f.size);
+    writeInt<Toc::timestamp_t>(data, pos + 0x10, static_cast<Toc::timestamp_t>(f.tim_begin));
+    writeInt<Toc::timestamp_t>(data, pos + 0x14, static_cast<Toc::timestamp_t>(f.tim_end));
+    writeInt<uint32_t>(data, pos + 0x18, static_cast<uint32_t>(f.path.size()));
+    pos += SIZE_FILE;
+
+    std::copy(f.path.begin(), f.path.end(), data + pos);
+    pos += f.path.size();
+  }
+
+  cs::File file;
+  if( !file.open(path, cs::FileOpenFlag::Write | cs::FileOpenFlag::Truncate) ) {
+    return false;
+  }
+
+  return file.write(buffer.data(), buffer.size()) == buffer.size();
+}
+
+void Catalog::refresh(const std::vector<std::filesystem::path>& roots)
+{
+  using namespace impl_catalog;
+
+  // (1) Lookup of Known Files ///////////////////////////////////////////////
+
+  std::unordered_map<std::string, std::size_t> known;
+  for( std::size_t i = 0; i < _files.size(); i++ ) {
+    known.emplace(_files[i].path, i);
+  }
+
+  std::vector<std::vector<const Interval *>> knownIntervals(_files.size());
+  for( const Interval& interval : _intervals ) {
+    knownIntervals[interval.id_file].push_back(&interval);
+  }
+
+  // (2) Scan Directory Trees ////////////////////////////////////////////////
+
+  std::vector<File> files;
+  std::vector<Interval> intervals;
+  std::vector<Scan> scans;
+
+  const auto add = [&](const std::filesystem::directory_entry& entry) -> void {
+    std::error_code ec;
+    if( !entry.is_regular_file(ec) ) {
+      return;
+    }
+
+    const uint64_t size = entry.file_size(ec);
+    if( ec || size < Toc::SIZE_TOC ) {
+      return;
+    }
+
+    const std::string path = entry.path().string();
+    const mtime_t mtime    = modificationTime(entry);
+    const auto hit         = known.find(path);
+    if( hit == known.end() || _files[hit->second].mtime != mtime || _files[hit->second].size != size ) {
+      scans.push_back({entry.path(), mtime, size, Toc()});
+      return;
+    }
+
+    const uint32_t id_file = static_cast<uint32_t>(files.size());
+    files.push_back(_files[hit->second]);
+    for( const Interval *interval : knownIntervals[hit->second] ) {
+      intervals.push_back(*interval);
+      intervals.back().id_file = id_file;
+    }
+  };
+
+  for( const std::filesystem::path& root : roots ) {
+    std::error_code ec;
+    if( std::filesystem::is_regular_file(root, ec) ) {
+      add(std::filesystem::directory_entry(root, ec));
+      continue;
+    }
+
+    walkDirectory(root, add);
+  }
+
+  // (3) Read TOCs of Added/Modified Files ///////////////////////////////////
+
+  readTocs(scans);
+
+  for( const Scan& scan : scans ) {
+    const Toc& toc = scan.toc;
+    if( !toc.isValid() ) {
+      continue;
+    }
+
+    const uint32_t id_file = static_cast<uint32_t>(files.size());
+    files.push_back({scan.path.string(), scan.mtime, scan.size, toc.tim_begin, toc.tim_end});
+
+    for( std::size_t i = 0; i < Toc::NUM_STREAMS; i++ ) {
+      if( toc.id_stream[i] == 0 ) {
+        continue;
+      }
+
+      Interval interval;
+      interval.id_camera = toc.id_camera[i];
+      interval.id_stream = toc.id_stream[i];
+      interval.id_file   = id_file;
+      interval.tim_begin = toc.tim_stream_begin[i];
+      interval.tim_end   = std::max({toc.tim_stream_begin[i],
+                                     toc.tim_stream_end1[i],
+                                     toc.tim_stream_end2[i]});
+      intervals.push_back(interval);
+    }
+  }
+
+  _files     = std::move(files);
+  _intervals = std::move(intervals);
+
+  index();
+}
+
+std::vector<const Catalog::Interval *> Catalog::query(const Toc::id_camera_t id_camera,
+                                                      const std::time_t t) const
+{
+  std::vector<const Interval *> result;
+
+  // NOTE: Intervals are sorted by (id_camera, tim_begin); max_end allows to
+  //       stop scanning backwards from the last interval beginning before t.
+
+  const auto last = std::upper_bound(_intervals.begin(), _intervals.end(), std::make_pair(id_camera, t),
+                                     [](const std::pair<Toc::id_camera_t, std::time_t>& key, const Interval& interval) -> bool {
+                                       return impl_catalog::isBefore(key.first, key.second, interval);
+                                     });
+
+  for( auto it = last; it != _intervals.begin(); ) {
+    --it;
+    if( it->id_camera != id_camera || it->max_end < t ) {
+      break;
+    }
+
+    if( it->tim_end >= t ) {
+      result.push_back(&*it);
+    }
+  }
+
+  std::reverse(result.begin(), result.end());
+
+  return result;
+}
+
+void Catalog::print(std::ostream *stream, const Interval *interval) const
+{
+  cs::println(stream, "% 0x% % %",
+              _files[interval->id_file].path,
+              cs::hexf(interval->id_stream, true),
+              formatTime(interval->tim_begin),
+              formatTime(interval->tim_end));
+}
+
+////// private ///////////////////////////////////////////////////////////////
+
+void Catalog::index()
+{
+  // NOTE: Ties are ordered by file and stream, so the order of a query's
+  //       results does not depend on the order of scanning.
+  std::sort(_intervals.begin(), _intervals.end(),
+            [this](const Interval& a, const Interval& b) -> bool {
+              if( a.id_camera != b.id_camera ) {
+                return a.id_camera < b.id_camera;
+              } else if( a.tim_begin != b.tim_begin ) {
+                return a.tim_begin < b.tim_begin;
+              } else if( a.id_file != b.id_file ) {
+                return _files[a.id_file].path < _files[b.id_file].path;
+              }
+              return a.id_stream < b.id_stream;
+            });
+
+  for( std::size_t i = 0; i < _intervals.size(); i++ ) {
+    Interval& interval = _intervals[i];
+
+    interval.max_end = i > 0 && _intervals[i - 1].id_camera == interval.id_camera
+                       ? std::max(_intervals[i - 1].max_end, interval.tim_end)
+                       : interval.tim_end;
+  }
+}
@@ -0,0 +1,777 @@
+/****************************************************************************
+** Copyright (c) 2023, Carsten Schmidt. All rights reserved.
+**
+** Redistribution and use in source and binary forms, with or without
+** modification, are permitted provided that the following conditions
+** are met:
+**
+** 1. Redistributions of source code must retain the above copyright
+**    notice, this list of conditions and the following disclaimer.
+**
+** 2. Redistributions in binary form must reproduce the above copyright
+**    notice, this list of conditions and the following disclaimer in the
+**    documentation and/or other materials provided with the distribution.
+**
+** 3. Neither the name of the copyright holder nor the names of its
+**    contributors may be used to endorse or promote products derived from
+**    this software without specific prior written permission.
+**
+** THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+** "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+** LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+** A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+** HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+** SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+** LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+** DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+** THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+** (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+** OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*****************************************************************************/
+
+#include <cerrno>
+#include <csignal>
+#include <cstdio>
+
+#ifndef _WIN32
+# include <fcntl.h>
+# include <poll.h>
+# include <sys/socket.h>
+# include <sys/stat.h>
+# include <sys/time.h>
+# include <sys/un.h>
+# include <unistd.h>
+#endif
+
+#include <algorithm>
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <sstream>
+#include <string_view>
+#include <thread>
+
+#include <cs/Text/PrintFormat.h>
+#include <cs/Text/PrintUtil.h>
+
+#include "daemon.h"
+
+#include "util.h"
+
+////// Private ///////////////////////////////////////////////////////////////
+
+namespace impl_daemon {
+
+  constexpr std::size_t SIZE_CHUNK  = 0x100000;
+  constexpr std::size_t MAX_REQUEST = 0x1000;
+  constexpr int TIMEOUT_POLL_MS     = 200;
+  constexpr int TIMEOUT_SEND_S      = 30;
+  constexpr int SIZE_LISTEN_BACKLOG = 64;
+
+#ifndef _WIN32
+  volatile std::sig_atomic_t is_stopped = 0;
+
+  void stop(int /*signal*/)
+  {
+    is_stopped = 1;
+  }
+
+  bool sendAll(const int fd, const void *data, std::size_t size)
+  {
+    const char *ptr = static_cast<const char *>(data);
+    while( size > 0 ) {
+      const ssize_t numSent = ::send(fd, ptr, size, MSG_NOSIGNAL);
+      if( numSent < 0 && errno == EINTR ) {
+        continue;
+      } else if( numSent <= 0 ) {
+        return false;
+      }
+
+      ptr  += numSent;
+      size -= static_cast<std::size_t>(numSent);
+    }
+    return true;
+  }
+
+  bool sendString(const int fd, const std::string_view s)
+  {
+    return sendAll(fd, s.data(), s.size());
+  }
+
+  bool sendError(const int fd, const std::string_view message)
+  {
+    std::string line("ERROR ");
+    line += message;
+    line += '\n';
+    return sendString(fd, line);
+  }
+
+  bool sendOk(const int fd, const std::string_view payload)
+  {
+    return sendString(fd, "OK " + std::to_string(payload.size()) + "\n")
+           && sendString(fd, payload);
+  }
+
+  // NOTE: A client connection; requests are received without blocking and
+  //       buffered until complete.
+  class Connection {
+  public:
+    Connection(const int fd) noexcept
+      : _fd{fd}
+    {
+    }
+
+    ~Connection() noexcept
+    {
+      ::close(_fd);
+    }
+
+    Connection(const Connection&)            = delete;
+    Connection& operator=(const Connection&) = delete;
+
+    int fd() const
+    {
+      return _fd;
+    }
+
+    bool hasLine() const
+    {
+      return _buffer.find('\n') != std::string::npos;
+    }
+
+    // NOTE: Receive what is available; returns false upon EOF, error or an
+    //       overlong line.
+    bool receive()
+    {
+      char chunk[4096];
+      ssize_t numRead = 0;
+      do {
+        numRead = ::recv(_fd, chunk, sizeof(chunk), MSG_DONTWAIT);
+      } while( numRead < 0 && errno == EINTR );
+
+      if( numRead < 0 && (errno == EAGAIN || errno == EWOULDBLOCK) ) {
+        return true;
+      } else if( numRead <= 0 ) {
+        return false;
+      }
+      _buffer.append(chunk, static_cast<std::size_t>(numRead));
+
+      return hasLine() || _buffer.size() <= MAX_REQUEST;
+    }
+
+    bool takeLine(std::string *line)
+    {
+      const std::size_t eol = _buffer.find('\n');
+      if( eol == std::string::npos ) {
+        return false;
+      }
+
+      line->assign(_buffer, 0, eol);
+      _buffer.erase(0, eol + 1);
+      if( !line->empty() && line->back() == '\r' ) {
+        line->pop_back();
+      }
+      return true;
+    }
+
+  private:
+    int _fd{-1};
+    std::string _buffer;
+  };
+
+  using ConnectionPtr = std::unique_ptr<Connection>;
+#endif
+
+  // NOTE: Split 'count' blank separated words off 'line'; the remainder of the
+  //       line is the path.
+  bool splitRequest(std::string_view line, std::vector<std::string_view> *words,
+                    const std::size_t count, std::string_view *path)
+  {
+    words->clear();
+    for( std::size_t i = 0; i < count; i++ ) {
+      const std::size_t sep = line.find(' ');
+      if( sep == std::string_view::npos ) {
+        return false;
+      }
+      words->push_back(line.substr(0, sep));
+      line.remove_prefix(sep + 1);
+    }
+    *path = line;
+    return !path->empty();
+  }
+
+  void printBlock(std::ostream *stream, const Block& block)
+  {
+    cs::println(stream, "0x% 0x% % % % % %",
+                cs::hexf(block.offset, true),
+                cs::hexf(block.id_stream, true),
+                toStringView(block.fourcc),
+                block.id_camera,
+                formatTime(block.timestamp),
+                block.block_size,
+                block.is_key ? 1 : 0);
+  }
+
+#ifndef _WIN32
+  class Server {
+  public:
+    Server(const DaemonOptions& options) noexcept
+      : _cache(options.cache_size)
+    {
+    }
+
+    // NOTE: Handle at most one request; returns false if the connection is
+    //       to be closed.
+    bool serve(Connection& connection);
+
+  private:
+    bool handle(const int fd, const std::string_view line);
+    bool handleToc(const int fd, const FileIndex& index);
+    bool handleList(const int fd, const FileIndex& index);
+    bool handleExtract(const int fd, const FileIndex& index,
+                       const Block::id_stream_t id_stream, const FourCC& fourcc,
+                       const std::time_t from, const std::time_t to);
+    bool handleRead(const int fd, const FileIndex& index,
+                    const Block::id_stream_t id_stream, const FourCC& fourcc,
+                    const std::size_t offset, const std::size_t length);
+
+    IndexCache _cache;
+  };
+
+  bool Server::serve(Connection& connection)
+  {
+    if( !connection.hasLine() && !connection.receive() ) {
+      return false;
+    }
+
+    std::string line;
+    while( connection.takeLine(&line) ) {
+      if( !line.empty() ) {
+        return handle(connection.fd(), line);
+      }
+    }
+
+    return true;
+  }
+
+  bool Server::handle(const int fd, const std::string_view line)
+  {
+    const std::size_t sep       = line.find(' ');
+    const std::string_view verb = line.substr(0, sep);
+    const std::string_view args = sep != std::string_view::npos
+                                  ? line.substr(sep + 1)
+                                  : std::string_view();
+
+    const std::size_t numWords = verb == "extract" || verb == "read"
+                                 ? 4
+                                 : 0;
+    if( numWords == 0 && verb != "toc" && verb != "list" ) {
+      return sendError(fd, "unknown request");
+    }
+
+    std::vector<std::string_view> words;
+    std::string_view path;
+    if( !splitRequest(args, &words, numWords, &path) ) {
+      return sendError(fd, "invalid request");
+    }
+
+    const FileIndexPtr index = _cache.get(path);
+    if( !index ) {
+      return sendError(fd, "unable to index file");
+    }
+
+    if( verb == "toc" ) {
+      return handleToc(fd, *index);
+    } else if( verb == "list" ) {
+      return handleList(fd, *index);
+    }
+
+    Block::id_stream_t id_stream = 0;
+    const FourCC fourcc          = makeFourCC(std::string(words[1]).data());
+    if( !parseInt(words[0], &id_stream) || isEmpty(fourcc) ) {
+      return sendError(fd, "invalid stream");
+    }
+
+    if( verb == "extract" ) {
+      std::time_t from = 0;
+      std::time_t to   = 0;
+      if( !parseTime(words[2], &from) || !parseTime(words[3], &to) ) {
+        return sendError(fd, "invalid time");
+      }
+      return handleExtract(fd, *index, id_stream, fourcc, from, to);
+    }
+
+    std::size_t offset = 0;
+    std::size_t length = 0;
+    if( !parseInt(words[2], &offset) || !parseInt(words[3], &length) ) {
+      return sendError(fd, "invalid range");
+    }
+    return handleRead(fd, *index, id_stream, fourcc, offset, length);
+  }
+
+  bool Server::handleToc(const int fd, const FileIndex& index)
+  {
+    std::ostringstream stream;
+    index.toc().print(&stream);
+    return sendOk(fd, stream.str());
+  }
+
+  bool Server::handleList(const int fd, const FileIndex& index)
+  {
+    std::ostringstream stream;
+    for( const Block& block : index.blocks() ) {
+      printBlock(&stream, block);
+    }
+    return sendOk(fd, stream.str());
+  }
+
+  bool Server::handleExtract(const int fd, const FileIndex& index,
+                             const Block::id_stream_t id_stream, const FourCC& fourcc,
+                             const std::time_t from, const std::time_t to)
+  {
+    const auto is_selected = [&](const Block& block) -> bool {
+      return block.id_stream == id_stream
+             && block.fourcc == fourcc
+             && block.timestamp >= from
+             && block.timestamp <= to;
+    };
+
+    // (1) Size of Response //////////////////////////////////////////////////
+
+    std::size_t size = 0;
+    for( const Block& block : index.blocks() ) {
+      if( is_selected(block) ) {
+        size += block.block_size;
+      }
+    }
+
+    BlockFile file;
+    if( !index.open(&file) ) {
+      return sendError(fd, "unable to open file");
+    }
+
+    if( !sendString(fd, "OK " + std::to_string(size) + "\n") ) {
+      return false;
+    }
+
+    // (2) Payloads //////////////////////////////////////////////////////////
+
+    // NOTE: Once the status is sent, the connection is dropped upon error.
+    cs::Buffer chunk;
+    for( const Block& block : index.blocks() ) {
+      if( is_stopped ) {
+        return false;
+      } else if( !is_selected(block) ) {
+        continue;
+      }
+
+      chunk.resize(block.block_size);
+      if( file.read(block.data(), chunk.data(), chunk.size()) != chunk.size()
+          || !sendAll(fd, chunk.data(), chunk.size()) ) {
+        return false;
+      }
+    }
+
+    return true;
+  }
+
+  bool Server::handleRead(const int fd, const FileIndex& index,
+                          const Block::id_stream_t id_stream, const FourCC& fourcc,
+                          const std::size_t offset, const std::size_t length)
+  {
+    const StreamMap *map = index.map(id_stream, fourcc);
+    if( map == nullptr ) {
+      return sendError(fd, "unknown stream");
+    }
+
+    const std::size_t size = offset < map->size()
+                             ? std::min(length, map->size() - offset)
+                             : 0;
+
+    BlockFile file;
+    if( !index.open(&file) ) {
+      return sendError(fd, "unable to open file");
+    }
+
+    if( !sendString(fd, "OK " + std::to_string(size) + "\n") ) {
+      return false;
+    }
+
+    cs::Buffer chunk(std::min(size, SIZE_CHUNK));
+    for( std::size_t pos = 0; pos < size; ) {
+      if( is_stopped ) {
+        return false;
+      }
+
+      const std::size_t numRead = map->read(file, offset + pos, chunk.data(),
+                                            std::min(size - pos, chunk.size()));
+      if( numRead == 0 || !sendAll(fd, chunk.data(), numRead) ) {
+        return false;
+      }
+      pos += numRead;
+    }
+
+    return true;
+  }
+#endif
+
+} // namespace impl_daemon
+
+////// FileIndex - public ////////////////////////////////////////////////////
+
+FileIndex::FileIndex() noexcept
+{
+}
+
+bool FileIndex::isCurrent() const
+{
+  std::error_code ec;
+
+  const std::filesystem::file_time_type mtime = std::filesystem::last_write_time(_path, ec);
+  if( ec || mtime != _mtime ) {
+    return false;
+  }
+
+  const std::uintmax_t size = std::filesystem::file_size(_path, ec);
+  return !ec && size == _size;
+}
+
+std::size_t FileIndex::memory() const
+{
+  std::size_t memory = sizeof(FileIndex)
+                       + _path.native().size()
+                       + _blocks.capacity() * sizeof(Block);
+  for( const auto& [key, map] : _maps ) {
+    memory += sizeof(key) + sizeof(map) + map.spans().capacity() * sizeof(StreamMap::Span);
+  }
+  return memory;
+}
+
+const std::filesystem::path& FileIndex::path() const
+{
+  return _path;
+}
+
+const Toc& FileIndex::toc() const
+{
+  return _toc;
+}
+
+const std::vector<Block>& FileIndex::blocks() const
+{
+  return _blocks;
+}
+
+const StreamMap *FileIndex::map(const Block::id_stream_t id_stream, const FourCC& fourcc) const
+{
+  const auto hit = _maps.find(StreamKey(id_stream, fourcc));
+  return hit != _maps.end()
+         ? &hit->second
+         : nullptr;
+}
+
+bool FileIndex::open(BlockFile *file) const
+{
+  return file->open(_path) && file->size() == _size;
+}
+
+////// FileIndex - public static /////////////////////////////////////////////
+
+FileIndexPtr FileIndex::build(const std::filesystem::path& path)
+{
+  std::shared_ptr<FileIndex> index = std::make_shared<FileIndex>();
+
+  // NOTE: Stat before reading; a concurrent modification renders the index
+  //       stale instead of going unnoticed.
+  std::error_code ec;
+  index->_mtime = std::filesystem::last_write_time(path, ec);
+
+  BlockFile file;
+  if( ec || !file.open(path) ) {
+    return FileIndexPtr();
+  }
+  index->_path = path;
+  index->_size = file.size();
+
+  index->_toc = file.readToc();
+  if( !index->_toc.isValid() ) {
+    return FileIndexPtr();
+  }
+
+  file.findWrap();
+  for( Block block = file.first(); block.isValid(); block = file.next(block) ) {
+    index->_blocks.push_back(block);
+    index->_maps[StreamKey(block.id_stream, block.fourcc)].add(block);
+  }
+  index->_blocks.shrink_to_fit();
+
+  return index;
+}
+
+////// IndexCache - public ///////////////////////////////////////////////////
+
+IndexCache::IndexCache(const std::size_t capacity) noexcept
+  : _capacity{capacity}
+{
+}
+
+FileIndexPtr IndexCache::get(const std::filesystem::path& path)
+{
+  std::error_code ec;
+  const std::string key = std::filesystem::weakly_canonical(path, ec).string();
+  if( ec ) {
+    return FileIndexPtr();
+  }
+
+  // (1) Lookup //////////////////////////////////////////////////////////////
+
+  {
+    std::lock_guard<std::mutex> lock(_mutex);
+
+    const auto hit = _entries.find(key);
+    if( hit != _entries.end() ) {
+      if( hit->second->second->isCurrent() ) {
+        _lru.splice(_lru.begin(), _lru, hit->second);
+        return hit->second->second;
+      }
+
+      _memory -= hit->second->second->memory();
+      _lru.erase(hit->second);
+      _entries.erase(hit);
+    }
+  }
+
+  // (2) Build Index /////////////////////////////////////////////////////////
+
+  // NOTE: Indexing is done without holding the lock; concurrent requests for
+  //       the same file may index it twice, the last one wins.
+  const FileIndexPtr index = FileIndex::build(key);
+  if( !index ) {
+    return FileIndexPtr();
+  }
+
+  // (3) Insert //////////////////////////////////////////////////////////////
+
+  std::lock_guard<std::mutex> lock(_mutex);
+
+  const auto hit = _entries.find(key);
+  if( hit != _entries.end() ) {
+    _memory -= hit->second->second->memory();
+    _lru.erase(hit->second);
+    _entries.erase(hit);
+  }
+
+  _lru.emplace_front(key, index);
+  _entries[key]  = _lru.begin();
+  _memory       += index->memory();
+
+  evict();
+
+  return index;
+}
+
+////// IndexCache - private //////////////////////////////////////////////////
+
+void IndexCache::evict()
+{
+  while( _memory > _capacity && _lru.size() > 1 ) {
+    const Entry& entry = _lru.back();
+
+    _memory -= entry.second->memory();
+    _entries.erase(entry.first);
+    _lru.pop_back();
+  }
+}
+
+////// Public ////////////////////////////////////////////////////////////////
+
+bool runDaemon(const std::filesystem::path& path, const DaemonOptions& options)
+{
+#ifndef _WIN32
+  using namespace impl_daemon;
+
+  // (1) Socket //////////////////////////////////////////////////////////////
+
+  sockaddr_un address{};
+  address.sun_family = AF_UNIX;
+  if( path.native().size() >= sizeof(address.sun_path) ) {
+    fprintf(stderr, "ERROR: Socket path \"%s\" is too long!\n", path.string().data());
+    return false;
+  }
+  std::copy(path.native().begin(), path.native().end(), address.sun_path);
+
+  const int fd_listen = ::socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+  if( fd_listen < 0 ) {
+    fprintf(stderr, "ERROR: Unable to create socket!\n");
+    return false;
+  }
+
+  // NOTE: A stale socket of a previous run is replaced.
+  ::unlink(path.c_str());
+  if( ::bind(fd_listen, reinterpret_cast<const sockaddr *>(&address), sizeof(address)) != 0
+      || ::chmod(path.c_str(), S_IRUSR | S_IWUSR) != 0
+      || ::listen(fd_listen, SIZE_LISTEN_BACKLOG) != 0 ) {
+    fprintf(stderr, "ERROR: Unable to listen on socket \"%s\"!\n", path.string().data());
+    ::close(fd_listen);
+    return false;
+  }
+
+  // (2) Signals /////////////////////////////////////////////////////////////
+
+  // NOTE: Without SA_RESTART, poll() returns upon a signal.
+  struct sigaction action {};
+  action.sa_handler = stop;
+  sigemptyset(&action.sa_mask);
+  sigaction(SIGINT, &action, nullptr);
+  sigaction(SIGTERM, &action, nullptr);
+  is_stopped = 0;
+
+  // (3) Workers /////////////////////////////////////////////////////////////
+
+  // NOTE: The acceptor polls all idle connections and queues those with
+  //       input; a worker handles one request, then either queues the
+  //       connection again if another request is buffered, or hands it back
+  //       to the acceptor. Idle connections thus never occupy a worker.
+  int fd_wake[2] = {-1, -1};
+  if( ::pipe2(fd_wake, O_CLOEXEC | O_NONBLOCK) != 0 ) {
+    fprintf(stderr, "ERROR: Unable to create pipe!\n");
+    ::close(fd_listen);
+    ::unlink(path.c_str());
+    return false;
+  }
+
+  Server server(options);
+
+  std::mutex mutex;
+  std::condition_variable cond_ready;
+  std::deque<ConnectionPtr> ready;
+  std::vector<ConnectionPtr> returned;
+  bool is_finished = false;
+
+  const auto worker = [&]() -> void {
+    for( ;; ) {
+      std::unique_lock<std::mutex> lock(mutex);
+      cond_ready.wait(lock, [&]() -> bool {
+        return is_finished || !ready.empty();
+      });
+      if( is_finished ) {
+        return;
+      }
+
+      ConnectionPtr connection = std::move(ready.front());
+      ready.pop_front();
+      lock.unlock();
+
+      if( !server.serve(*connection) ) {
+        continue;
+      }
+
+      lock.lock();
+      if( connection->hasLine() ) {
+        ready.push_back(std::move(connection));
+        continue;
+      }
+      returned.push_back(std::move(connection));
+      lock.unlock();
+
+      const char wake = 0;
+      [[maybe_unused]] const ssize_t numWritten = ::write(fd_wake[1], &wake, 1);
+    }
+  };
+
+  const std::size_t numWorkers = options.num_workers > 0
+                                 ? options.num_workers
+                                 : std::max(std::thread::hardware_concurrency(), 1u);
+
+  std::vector<std::thread> workers;
+  for( std::size_t i = 0; i < numWorkers; i++ ) {
+    workers.emplace_back(worker);
+  }
+
+  // (4) Accept & Poll Connections ///////////////////////////////////////////
+
+  fprintf(stderr, "Listening on \"%s\" (%zu workers).\n", path.string().data(), numWorkers);
+
+  std::vector<ConnectionPtr> idle;
+  std::vector<pollfd> pfds;
+  while( !is_stopped ) {
+    pfds.clear();
+    pfds.push_back({fd_wake[0], POLLIN, 0});
+    pfds.push_back({fd_listen, POLLIN, 0});
+    for( const ConnectionPtr& connection : idle ) {
+      pfds.push_back({connection->fd(), POLLIN, 0});
+    }
+
+    if( ::poll(pfds.data(), pfds.size(), TIMEOUT_POLL_MS) <= 0 ) {
+      continue;
+    }
+
+    if( pfds[0].revents != 0 ) {
+      char drain[64];
+      while( ::read(fd_wake[0], drain, sizeof(drain)) > 0 ) {
+      }
+    }
+
+    {
+      std::lock_guard<std::mutex> lock(mutex);
+
+      // NOTE: Traversed backwards; the last connection replaces the one
+      //       queued, and has already been visited.
+      for( std::size_t i = idle.size(); i-- > 0; ) {
+        if( pfds[i + 2].revents == 0 ) {
+          continue;
+        }
+
+        ready.push_back(std::move(idle[i]));
+        idle[i] = std::move(idle.back());
+        idle.pop_back();
+      }
+
+      for( ConnectionPtr& connection : returned ) {
+        idle.push_back(std::move(connection));
+      }
+      returned.clear();
+    }
+    cond_ready.notify_all();
+
+    if( pfds[1].revents == 0 ) {
+      continue;
+    }
+
+    const int fd = ::accept4(fd_listen, nullptr, nullptr, SOCK_CLOEXEC);
+    if( fd < 0 ) {
+      continue;
+    }
+
+    // NOTE: A client not reading its response is dropped after a while
+    //       instead of occupying a worker.
+    const timeval timeout{TIMEOUT_SEND_S, 0};
+    ::setsockopt(fd, SOL_SOCKET, SO_SNDTIMEO, &timeout, sizeof(timeout));
+
+    idle.push_back(std::make_unique<Connection>(fd));
+  }
+
+  // (5) Shutdown ////////////////////////////////////////////////////////////
+
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    is_finished = true;
+  }
+  cond_ready.notify_all();
+
+  ::close(fd_listen);
+  ::unlink(path.c_str());
+
+  for( std::thread& thread : workers ) {
+    thread.join();
+  }
+
+  ::close(fd_wake[0]);
+  ::close(fd_wake[1]);
+
+  return true;
+#else
+  fprintf(stderr, "ERROR: The daemon requires Unix domain sockets!\n");
+  return false;
+#endif
+}
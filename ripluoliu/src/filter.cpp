@@ -0,0 +1,170 @@
+/****************************************************************************
+** Copyright (c) 2023, Carsten Schmidt. All rights reserved.
+**
+** Redistribution and use in source and binary forms, with or without
+** modification, are permitted provided that the following conditions
+** are met:
+**
+** 1. Redistributions of source code must retain the above copyright
+**    notice, this list of conditions and the following disclaimer.
+**
+** 2. Redistributions in binary form must reproduce the above copyright
+**    notice, this list of conditions and the following disclaimer in the
+**    documentation and/or other materials provided with the distribution.
+**
+** 3. Neither the name of the copyright holder nor the names of its
+**    contributors may be used to endorse or promote products derived from
+**    this software without specific prior written permission.
+**
+** THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+** "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+** LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+** A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+** HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+** SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+** LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+** DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+** THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+** (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+** OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*****************************************************************************/
+
+#include <algorithm>
+
+#include "filter.h"
+
+////// Private ///////////////////////////////////////////////////////////////
+
+namespace impl_filter {
+
+  template <typename T>
+  inline bool contains(const std::vector<T>& set, const T& value)
+  {
+    return set.empty() || std::find(set.begin(), set.end(), value) != set.end();
+  }
+
+} // namespace impl_filter
+
+////// public ////////////////////////////////////////////////////////////////
+
+Filter::Filter() noexcept
+{
+}
+
+bool Filter::isEmpty() const
+{
+  return fourccs.empty();
+}
+
+void Filter::compile(const Toc& toc, const SinkFactory& factory)
+{
+  close();
+
+  // NOTE: Size the table once; it is not touched while running.
+  _table.reserve(Toc::NUM_STREAMS * fourccs.size());
+  _sinks.reserve(Toc::NUM_STREAMS * fourccs.size());
+
+  for( std::size_t i = 0; i < Toc::NUM_STREAMS; i++ ) {
+    const Toc::id_stream_t id = toc.id_stream[i];
+    if( id == 0 ) {
+      continue;
+    }
+
+    if( !impl_filter::contains(streams, id) || !impl_filter::contains(cameras, toc.id_camera[i]) ) {
+      continue;
+    }
+
+    for( const FourCC& fourcc : fourccs ) {
+      const key_t key = makeKey(id, fourcc);
+      if( std::any_of(_table.begin(), _table.end(),
+                      [&](const Entry& entry) -> bool { return entry.key == key; }) ) {
+        continue;
+      }
+
+      SinkPtr sink = factory(id, fourcc);
+      if( !sink ) {
+        continue;
+      }
+
+      _table.push_back({key, sink.get(), sink->checksKeyFrames()});
+      _sinks.push_back(std::move(sink));
+    }
+  }
+
+  std::sort(_table.begin(), _table.end(),
+            [](const Entry& a, const Entry& b) -> bool {
+              return a.key < b.key;
+            });
+}
+
+Sink *Filter::match(const Block& block) const
+{
+  if( block.timestamp < tim_begin || block.timestamp > tim_end ) {
+    return nullptr;
+  }
+
+  const key_t key = makeKey(block.id_stream, block.fourcc);
+
+  const auto hit = std::lower_bound(_table.begin(), _table.end(), key,
+                                    [](const Entry& entry, const key_t key) -> bool {
+                                      return entry.key < key;
+                                    });
+  if( hit == _table.end() || hit->key != key ) {
+    return nullptr;
+  }
+
+  if( is_key_only && !block.is_key && !hit->is_checking_keys ) {
+    return nullptr;
+  }
+
+  return hit->sink;
+}
+
+bool Filter::accepts(const Block& block, const Toc::id_camera_t id_camera) const
+{
+  if( block.timestamp < tim_begin || block.timestamp > tim_end ) {
+    return false;
+  }
+
+  if( is_key_only && !block.is_key ) {
+    return false;
+  }
+
+  return impl_filter::contains(fourccs, block.fourcc)
+         && impl_filter::contains(streams, block.id_stream)
+         && impl_filter::contains(cameras, id_camera);
+}
+
+void Filter::run(const cs::Buffer& buffer, const Wrap& wrap) const
+{
+  BufferReader reader{buffer};
+  forEachBlock(reader, wrap, [&](const Block& block) -> void {
+    Sink *sink = match(block);
+    if( sink == nullptr ) {
+      return;
+    }
+
+    sink->write(block, buffer.data() + block.data(), block.block_size);
+  });
+}
+
+void Filter::close()
+{
+  for( SinkPtr& sink : _sinks ) {
+    sink->close();
+  }
+
+  _table.clear();
+  _sinks.clear();
+}
+
+////// private static ////////////////////////////////////////////////////////
+
+Filter::key_t Filter::makeKey(const Block::id_stream_t id_stream, const FourCC& fourcc)
+{
+  key_t key = id_stream;
+  for( const char c : fourcc ) {
+    key = (key << 8) | static_cast<uint8_t>(c);
+  }
+  return key;
+}
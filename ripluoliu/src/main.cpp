@@ -32,8 +32,11 @@
 #include <cstdio>
 #include <cstdlib>
 
+#include <algorithm>
 #include <filesystem>
 #include <iostream>
+#include <memory>
+#include <vector>
 
 #include <cs/IO/File.h>
 #include <cs/Text/PrintFormat.h>
@@ -41,66 +44,242 @@
 #include <cs/Text/StringUtil.h>
 
 #include "block.h"
+#include "catalog.h"
+#include "daemon.h"
+#include "filter.h"
 #include "fourcc.h"
+#include "merge.h"
+#include "nal.h"
+#include "pipe.h"
+#include "probe.h"
+#include "repack.h"
+#include "report.h"
+#include "segment.h"
+#include "sink.h"
+#include "streammap.h"
 #include "toc.h"
 #include "util.h"
+#include "wrap.h"
 
 ////// Operations ////////////////////////////////////////////////////////////
 
-void extractStream(const std::filesystem::path& output, const cs::Buffer& buffer,
-                   const Block::id_stream_t id_stream, const FourCC& fourcc)
+struct Extraction {
+  bool nal_index{false};
+  bool nal_drop{false};
+  Segmentation segmentation;
+  bool is_stdout{false};
+  std::filesystem::path fifo_dir;
+
+  bool isPiped() const
+  {
+    return is_stdout || !fifo_dir.empty();
+  }
+};
+
+bool extractAllStreams(const std::filesystem::path& input,
+                       const cs::Buffer& buffer,
+                       Filter& filter,
+                       const Extraction& extraction,
+                       const Wrap& wrap)
 {
-  cs::File file;
-  if( !file.open(output, cs::FileOpenFlag::Write | cs::FileOpenFlag::Truncate) ) {
-    return;
+  if( input.empty() || buffer.empty() || filter.isEmpty() ) {
+    return false;
   }
 
-  for( Block block = Block::read(buffer, Toc::SIZE_TOC);
-       block.isValid();
-       block = Block::read(buffer, block.next()) ) {
-    if( block.id_stream != id_stream || block.fourcc != fourcc ) {
-      continue;
+  const Toc toc = Toc::read(buffer);
+
+  std::unique_ptr<WriterPool> pool;
+  if( extraction.segmentation.isEnabled() ) {
+    pool = std::make_unique<WriterPool>();
+  }
+
+  bool has_stdout = false;
+  filter.compile(toc, [&](const Block::id_stream_t id_stream, const FourCC& fourcc) -> SinkPtr {
+    const std::filesystem::path output = outputPath(input, id_stream, fourcc);
+
+    SinkPtr sink;
+    if( extraction.is_stdout ) {
+      if( has_stdout ) {
+        fprintf(stderr, "ERROR: Skipping \"%s\"; only one stream may be written to stdout!\n",
+                output.string().data());
+        return SinkPtr();
+      }
+      sink       = PipeSink::make(std::filesystem::path());
+      has_stdout = true;
+    } else if( !extraction.fifo_dir.empty() ) {
+      sink = PipeSink::make(extraction.fifo_dir / output);
+    } else if( extraction.segmentation.isEnabled() ) {
+      sink = SegmentSink::make(pool.get(), extraction.segmentation, input, id_stream, fourcc);
+    } else {
+      sink = FileSink::make(output);
+    }
+
+    const NalCodec codec = nalCodec(fourcc);
+    // NOTE: Key frames of H.264/H.265 are determined from the NAL units,
+    //       since the header's key frame flag is not reliable.
+    if( codec != NalCodec::None && (extraction.nal_index || extraction.nal_drop || filter.is_key_only) ) {
+      std::filesystem::path index;
+      if( extraction.nal_index ) {
+        index = output;
+        index += ".nal";
+      }
+      sink = NalSink::make(std::move(sink), codec, index, extraction.nal_drop, filter.is_key_only);
+    }
+
+    return sink;
+  });
+  filter.run(buffer, wrap);
+  filter.close();
+
+  return !pool || pool->finish();
+}
+
+bool catalogFiles(const std::filesystem::path& path,
+                  const std::vector<std::filesystem::path>& roots,
+                  const bool is_query,
+                  const Toc::id_camera_t id_camera, const std::time_t t)
+{
+  Catalog catalog;
+
+  // NOTE: A pure query reads only the matching intervals and their files;
+  //       a missing or invalid catalog is rebuilt when refreshing.
+  if( roots.empty() ) {
+    const bool is_loaded = is_query
+                           ? catalog.load(path, id_camera, t)
+                           : catalog.load(path);
+    if( !is_loaded ) {
+      fprintf(stderr, "ERROR: Unable to read catalog \"%s\"!\n", path.string().data());
+      return false;
     }
 
-    file.write(buffer.data() + block.data(), block.block_size);
+  } else {
+    catalog.load(path);
+    catalog.refresh(roots);
+    if( !catalog.save(path) ) {
+      fprintf(stderr, "ERROR: Unable to write catalog \"%s\"!\n", path.string().data());
+      return false;
+    }
+  }
+
+  if( is_query ) {
+    for( const Catalog::Interval *interval : catalog.query(id_camera, t) ) {
+      catalog.print(&std::cout, interval);
+    }
   }
+
+  return true;
 }
 
-void extractAllStreams(const std::filesystem::path& input,
-                       const cs::Buffer& buffer,
-                       const FourCC& fourcc)
+void mapStream(const std::filesystem::path& input,
+               const Block::id_stream_t id_stream, const FourCC& fourcc,
+               const bool is_read, const std::size_t offset, const std::size_t length)
 {
-  if( input.empty() || buffer.empty() || isEmpty(fourcc) ) {
+  constexpr std::size_t SIZE_CHUNK = 0x100000;
+
+  BlockFile file;
+  if( !file.open(input) ) {
+    fprintf(stderr, "ERROR: Unable to open file \"%s\"!\n", input.string().data());
     return;
   }
 
-  const Toc toc = Toc::read(buffer);
+  const StreamMap map = StreamMap::build(file, id_stream, fourcc);
+  if( !is_read ) {
+    map.print(&std::cout);
+    return;
+  }
 
-  for( std::size_t i = 0; i < Toc::NUM_STREAMS; i++ ) {
-    const Toc::id_stream_t id = toc.id_stream[i];
-    if( id == 0 ) {
-      continue;
+  cs::Buffer chunk(std::min(length, SIZE_CHUNK));
+  for( std::size_t pos = 0; pos < length; ) {
+    const std::size_t numRead = map.read(file, offset + pos, chunk.data(),
+                                         std::min(length - pos, chunk.size()));
+    if( numRead == 0 || fwrite(chunk.data(), 1, numRead, stdout) != numRead ) {
+      break;
     }
+    pos += numRead;
+  }
+}
 
-    const std::string output = cs::sprint("%-0x%.%",
-                                          input.stem().string(),
-                                          cs::hexf(id, true),
-                                          cs::toLower(toString(fourcc)));
-    extractStream(output, buffer, id, fourcc);
+bool reportFile(const std::filesystem::path& input, const bool is_json)
+{
+  BlockFile file;
+  if( !file.open(input) ) {
+    fprintf(stderr, "ERROR: Unable to open file \"%s\"!\n", input.string().data());
+    return false;
   }
+
+  const Report report = Report::run(file);
+  if( is_json ) {
+    report.printJson(&std::cout);
+  } else {
+    report.print(&std::cout);
+  }
+
+  return true;
 }
 
 ////// Main //////////////////////////////////////////////////////////////////
 
-const char *arg_filename = NULL;
-FourCC arg_fourcc;
+std::vector<std::filesystem::path> arg_filenames;
+Filter arg_filter;
+Extraction arg_extraction;
+bool arg_report      = false;
+bool arg_report_json = false;
+bool arg_probe       = false;
+bool arg_merge       = false;
+std::filesystem::path arg_repack;
+std::filesystem::path arg_catalog;
+std::filesystem::path arg_daemon;
+DaemonOptions arg_daemon_options;
+bool arg_query                    = false;
+Toc::id_camera_t arg_query_camera = 0;
+std::time_t arg_query_time        = 0;
+bool arg_map                      = false;
+Block::id_stream_t arg_map_stream = 0;
+bool arg_map_read                 = false;
+std::size_t arg_map_offset        = 0;
+std::size_t arg_map_length        = 0;
+
+template <typename T, typename ParseFunc>
+bool parseList(const std::string_view s, std::vector<T> *list, ParseFunc parse)
+{
+  list->clear();
+  for( std::size_t pos = 0; pos <= s.size(); ) {
+    const std::size_t sep = std::min(s.find(',', pos), s.size());
+
+    T value{};
+    if( !parse(s.substr(pos, sep - pos), &value) ) {
+      return false;
+    }
+    list->push_back(value);
+
+    pos = sep + 1;
+  }
+  return !list->empty();
+}
 
 bool parseArgs(const int argc, char **argv)
 {
   // (1) Initialize arguments ////////////////////////////////////////////////
 
-  arg_filename = NULL;
-  arg_fourcc.fill('\0');
+  arg_filenames.clear();
+  arg_filter       = Filter();
+  arg_extraction   = Extraction();
+  arg_report       = false;
+  arg_report_json  = false;
+  arg_probe        = false;
+  arg_merge        = false;
+  arg_repack.clear();
+  arg_catalog.clear();
+  arg_daemon.clear();
+  arg_daemon_options = DaemonOptions();
+  arg_query          = false;
+  arg_query_camera   = 0;
+  arg_query_time     = 0;
+  arg_map            = false;
+  arg_map_stream     = 0;
+  arg_map_read       = false;
+  arg_map_offset     = 0;
+  arg_map_length     = 0;
 
   // (2) Scan for optional arguments beginning with '-' //////////////////////
 
@@ -111,14 +290,141 @@ bool parseArgs(const int argc, char **argv)
     }
 
     if( cs::startsWith(argv[opt], "--rip=") ) {
-      const char *opt_fourcc = &argv[opt][6];
+      const auto parseFourCC = [](const std::string_view s, FourCC *fourcc) -> bool {
+        *fourcc = makeFourCC(std::string(s).data());
+        return !isEmpty(*fourcc);
+      };
 
-      arg_fourcc = makeFourCC(opt_fourcc);
-      if( isEmpty(arg_fourcc) ) {
+      const char *opt_fourcc = &argv[opt][6];
+      if( !parseList(opt_fourcc, &arg_filter.fourccs, parseFourCC) ) {
         fprintf(stderr, "ERROR: Invalid FourCC \"%s\"!\n", opt_fourcc);
         return false;
       }
 
+    } else if( cs::startsWith(argv[opt], "--stream=") ) {
+      const char *opt_streams = &argv[opt][9];
+      if( !parseList(opt_streams, &arg_filter.streams, parseInt<Block::id_stream_t>) ) {
+        fprintf(stderr, "ERROR: Invalid streams \"%s\"!\n", opt_streams);
+        return false;
+      }
+
+    } else if( cs::startsWith(argv[opt], "--camera=") ) {
+      const char *opt_cameras = &argv[opt][9];
+      if( !parseList(opt_cameras, &arg_filter.cameras, parseInt<Block::id_camera_t>) ) {
+        fprintf(stderr, "ERROR: Invalid cameras \"%s\"!\n", opt_cameras);
+        return false;
+      }
+
+    } else if( cs::startsWith(argv[opt], "--from=") ) {
+      const char *opt_time = &argv[opt][7];
+      if( !parseTime(opt_time, &arg_filter.tim_begin) ) {
+        fprintf(stderr, "ERROR: Invalid time \"%s\"!\n", opt_time);
+        return false;
+      }
+
+    } else if( cs::startsWith(argv[opt], "--to=") ) {
+      const char *opt_time = &argv[opt][5];
+      if( !parseTime(opt_time, &arg_filter.tim_end) ) {
+        fprintf(stderr, "ERROR: Invalid time \"%s\"!\n", opt_time);
+        return false;
+      }
+
+    } else if( std::string_view(argv[opt]) == "--key-only" ) {
+      arg_filter.is_key_only = true;
+
+    } else if( std::string_view(argv[opt]) == "--nal-index" ) {
+      arg_extraction.nal_index = true;
+
+    } else if( std::string_view(argv[opt]) == "--nal-drop" ) {
+      arg_extraction.nal_drop = true;
+
+    } else if( cs::startsWith(argv[opt], "--segment=") ) {
+      const char *opt_duration = &argv[opt][10];
+      if( !parseDuration(opt_duration, &arg_extraction.segmentation.duration) ) {
+        fprintf(stderr, "ERROR: Invalid duration \"%s\"!\n", opt_duration);
+        return false;
+      }
+
+    } else if( cs::startsWith(argv[opt], "--segment-size=") ) {
+      const char *opt_size = &argv[opt][15];
+      if( !parseSize(opt_size, &arg_extraction.segmentation.size) ) {
+        fprintf(stderr, "ERROR: Invalid size \"%s\"!\n", opt_size);
+        return false;
+      }
+
+    } else if( std::string_view(argv[opt]) == "--stdout" ) {
+      arg_extraction.is_stdout = true;
+
+    } else if( cs::startsWith(argv[opt], "--fifo=") ) {
+      arg_extraction.fifo_dir = &argv[opt][7];
+
+    } else if( std::string_view(argv[opt]) == "--report" ) {
+      arg_report = true;
+
+    } else if( std::string_view(argv[opt]) == "--report=json" ) {
+      arg_report      = true;
+      arg_report_json = true;
+
+    } else if( std::string_view(argv[opt]) == "--probe" ) {
+      arg_probe = true;
+
+    } else if( cs::startsWith(argv[opt], "--repack=") ) {
+      arg_repack = &argv[opt][9];
+
+    } else if( std::string_view(argv[opt]) == "--merge" ) {
+      arg_merge = true;
+
+    } else if( cs::startsWith(argv[opt], "--catalog=") ) {
+      arg_catalog = &argv[opt][10];
+
+    } else if( cs::startsWith(argv[opt], "--daemon=") ) {
+      arg_daemon = &argv[opt][9];
+
+    } else if( cs::startsWith(argv[opt], "--cache-size=") ) {
+      const char *opt_size = &argv[opt][13];
+      if( !parseSize(opt_size, &arg_daemon_options.cache_size) ) {
+        fprintf(stderr, "ERROR: Invalid size \"%s\"!\n", opt_size);
+        return false;
+      }
+
+    } else if( cs::startsWith(argv[opt], "--workers=") ) {
+      const char *opt_workers = &argv[opt][10];
+      if( !parseInt(opt_workers, &arg_daemon_options.num_workers) ) {
+        fprintf(stderr, "ERROR: Invalid number of workers \"%s\"!\n", opt_workers);
+        return false;
+      }
+
+    } else if( cs::startsWith(argv[opt], "--query=") ) {
+      const std::string_view opt_query = &argv[opt][8];
+      const std::size_t at             = opt_query.find('@');
+
+      arg_query = at != std::string_view::npos
+                  && parseInt(opt_query.substr(0, at), &arg_query_camera)
+                  && parseTime(opt_query.substr(at + 1), &arg_query_time);
+      if( !arg_query ) {
+        fprintf(stderr, "ERROR: Invalid query \"%s\"!\n", opt_query.data());
+        return false;
+      }
+
+    } else if( cs::startsWith(argv[opt], "--map=") ) {
+      const std::string_view opt_map = &argv[opt][6];
+      const std::size_t sep1         = opt_map.find(':');
+      const std::size_t sep2         = opt_map.find(':', sep1 + 1);
+
+      arg_map      = parseInt(opt_map.substr(0, sep1), &arg_map_stream);
+      arg_map_read = sep1 != std::string_view::npos;
+      if( arg_map_read ) {
+        arg_map = arg_map
+                  && sep2 != std::string_view::npos
+                  && parseInt(opt_map.substr(sep1 + 1, sep2 - sep1 - 1), &arg_map_offset)
+                  && parseInt(opt_map.substr(sep2 + 1), &arg_map_length);
+      }
+
+      if( !arg_map ) {
+        fprintf(stderr, "ERROR: Invalid mapping \"%s\"!\n", opt_map.data());
+        return false;
+      }
+
     } else {
       fprintf(stderr, "ERROR: Invalid option \"%s\"!\n", argv[opt]);
       return false;
@@ -127,20 +433,83 @@ bool parseArgs(const int argc, char **argv)
 
   // (3) Do non-optional arguments exist? ////////////////////////////////////
 
-  if( opt >= argc ) { // all arguments consumed!
+  if( opt >= argc && !arg_query && arg_daemon.empty() ) { // all arguments consumed!
     return false;
   }
 
   // (4) Read arguments //////////////////////////////////////////////////////
 
-  arg_filename = argv[opt++];
+  for( ; opt < argc; opt++ ) {
+    arg_filenames.push_back(argv[opt]);
+  }
+
+  // (5) Check arguments /////////////////////////////////////////////////////
+
+  if( arg_query && arg_catalog.empty() ) {
+    fprintf(stderr, "ERROR: Querying requires option \"--catalog=<catalog-filename>\"!\n");
+    return false;
+  }
+
+  if( !arg_catalog.empty() ) {
+    return true;
+  }
 
-  return opt == argc;
+  if( !arg_daemon.empty() ) {
+    return arg_filenames.empty();
+  }
+
+  if( arg_map && arg_filter.fourccs.size() != 1 ) {
+    fprintf(stderr, "ERROR: Mapping requires option \"--rip=<FourCC>\"!\n");
+    return false;
+  }
+
+  if( arg_extraction.isPiped() && arg_extraction.segmentation.isEnabled() ) {
+    fprintf(stderr, "ERROR: Piped output can not be segmented!\n");
+    return false;
+  }
+
+  // NOTE: The offsets of a NAL index refer to the concatenated stream.
+  if( arg_extraction.nal_index && arg_extraction.segmentation.isEnabled() ) {
+    fprintf(stderr, "ERROR: Segmented output can not be NAL indexed!\n");
+    return false;
+  }
+
+  if( arg_extraction.is_stdout && !arg_extraction.fifo_dir.empty() ) {
+    fprintf(stderr, "ERROR: Output is either stdout or FIFOs!\n");
+    return false;
+  }
+
+  if( arg_probe ) {
+    return true;
+  }
+
+  if( arg_merge ) {
+    if( arg_filter.fourccs.size() != 1 ) {
+      fprintf(stderr, "ERROR: Merging requires option \"--rip=<FourCC>\"!\n");
+      return false;
+    }
+    return true;
+  }
+
+  return arg_filenames.size() == 1;
 }
 
 void usage(const char *prog)
 {
-  fprintf(stderr, "Usage: %s [--rip=<FourCC>] <input-filename>\n", prog);
+  fprintf(stderr, "Usage: %s [--rip=<FourCC>[,...]] [<filter>...] <input-filename>\n", prog);
+  fprintf(stderr, "       %s --report[=json] <input-filename>\n", prog);
+  fprintf(stderr, "       %s --repack=<output-filename> [--rip=<FourCC>[,...]] [<filter>...] <input-filename>\n", prog);
+  fprintf(stderr, "       %s --probe <input-filename|input-directory>...\n", prog);
+  fprintf(stderr, "       %s --rip=<FourCC> --merge <input-filename>...\n", prog);
+  fprintf(stderr, "       %s --rip=<FourCC> --map=<id_stream>[:<offset>:<length>] <input-filename>\n", prog);
+  fprintf(stderr, "       %s --daemon=<socket-path> [--cache-size=<size>[K|M|G]] [--workers=<count>]\n", prog);
+  fprintf(stderr, "       %s --catalog=<catalog-filename> [--query=<id_camera>@<time>] [<input-directory>...]\n", prog);
+  fprintf(stderr, "\n");
+  fprintf(stderr, "Filter: --stream=<id_stream>[,...] --camera=<id_camera>[,...]\n");
+  fprintf(stderr, "        --from=<time> --to=<time> --key-only\n");
+  fprintf(stderr, "H.264/H.265: --nal-index --nal-drop\n");
+  fprintf(stderr, "Output: --segment=<duration>[s|m|h] --segment-size=<size>[K|M|G]\n");
+  fprintf(stderr, "        --stdout --fifo=<directory>\n");
 }
 
 int main(int argc, char **argv)
@@ -152,24 +521,98 @@ int main(int argc, char **argv)
     return EXIT_FAILURE;
   }
 
-  // (2) File I/O ////////////////////////////////////////////////////////////
+  // (2) Multi-File Operations ///////////////////////////////////////////////
+
+  if( !arg_daemon.empty() ) {
+    return runDaemon(arg_daemon, arg_daemon_options)
+           ? EXIT_SUCCESS
+           : EXIT_FAILURE;
+  }
+
+  if( !arg_catalog.empty() ) {
+    return catalogFiles(arg_catalog, arg_filenames,
+                        arg_query, arg_query_camera, arg_query_time)
+           ? EXIT_SUCCESS
+           : EXIT_FAILURE;
+  }
+
+  if( arg_probe ) {
+    for( const Probe& probe : probeFiles(arg_filenames) ) {
+      probe.print(&std::cout);
+    }
+    return EXIT_SUCCESS;
+  }
+
+  if( arg_merge ) {
+    mergeCameras(arg_filenames, arg_filter.fourccs.front());
+    return EXIT_SUCCESS;
+  }
+
+  // (3) Single-File Operations //////////////////////////////////////////////
+
+  const std::filesystem::path& arg_filename = arg_filenames.front();
+
+  if( !arg_repack.empty() ) {
+    const long long numBlocks = repackFile(arg_filename, arg_repack, arg_filter);
+    if( numBlocks < 0 ) {
+      fprintf(stderr, "ERROR: Unable to repack \"%s\" to \"%s\"!\n",
+              arg_filename.string().data(), arg_repack.string().data());
+      return EXIT_FAILURE;
+    }
+    fprintf(stderr, "Repacked %lld blocks.\n", numBlocks);
+    return EXIT_SUCCESS;
+  }
+
+  if( arg_map ) {
+    mapStream(arg_filename, arg_map_stream, arg_filter.fourccs.front(),
+              arg_map_read, arg_map_offset, arg_map_length);
+    return EXIT_SUCCESS;
+  }
+
+  // NOTE: Without extraction, the report reads the block headers only.
+  if( arg_report && arg_filter.isEmpty() ) {
+    return reportFile(arg_filename, arg_report_json)
+           ? EXIT_SUCCESS
+           : EXIT_FAILURE;
+  }
+
+  // (4) File I/O ////////////////////////////////////////////////////////////
 
   cs::File file;
   if( !file.open(arg_filename) ) {
-    fprintf(stderr, "ERROR: Unable to open file \"%s\"!\n", arg_filename);
+    fprintf(stderr, "ERROR: Unable to open file \"%s\"!\n", arg_filename.string().data());
     usage(argv[0]);
     return EXIT_FAILURE;
   }
 
   const cs::Buffer buffer = file.readAll();
 
-  // (3) Work ////////////////////////////////////////////////////////////////
+  // (5) Work ////////////////////////////////////////////////////////////////
 
-  const Toc toc = Toc::read(buffer);
-  toc.print();
+  const Toc toc   = Toc::read(buffer);
+  const Wrap wrap = Wrap::find(buffer);
 
-  if( !isEmpty(arg_fourcc) ) {
-    extractAllStreams(arg_filename, buffer, arg_fourcc);
+  // NOTE: Keep stdout clean for the piped stream.
+  std::ostream *stream = arg_extraction.is_stdout
+                         ? &std::cerr
+                         : &std::cout;
+
+  if( arg_report ) {
+    const Report report = Report::run(buffer, wrap);
+    if( arg_report_json ) {
+      report.printJson(stream);
+    } else {
+      report.print(stream);
+    }
+  } else {
+    toc.print(stream);
+    wrap.print(stream);
+  }
+
+  if( !arg_filter.isEmpty()
+      && !extractAllStreams(arg_filename, buffer, arg_filter,
+                            arg_extraction, wrap) ) {
+    return EXIT_FAILURE;
   }
 
   return EXIT_SUCCESS;
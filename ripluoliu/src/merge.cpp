@@ -0,0 +1,234 @@
+/****************************************************************************
+** Copyright (c) 2023, Carsten Schmidt. All rights reserved.
+**
+** Redistribution and use in source and binary forms, with or without
+** modification, are permitted provided that the following conditions
+** are met:
+**
+** 1. Redistributions of source code must retain the above copyright
+**    notice, this list of conditions and the following disclaimer.
+**
+** 2. Redistributions in binary form must reproduce the above copyright
+**    notice, this list of conditions and the following disclaimer in the
+**    documentation and/or other materials provided with the distribution.
+**
+** 3. Neither the name of the copyright holder nor the names of its
+**    contributors may be used to endorse or promote products derived from
+**    this software without specific prior written permission.
+**
+** THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+** "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+** LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+** A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+** HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+** SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+** LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+** DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+** THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+** (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+** OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*****************************************************************************/
+
+#include <cstdio>
+
+#include <algorithm>
+#include <map>
+#include <memory>
+#include <queue>
+
+#include <cs/IO/File.h>
+#include <cs/Text/PrintFormat.h>
+#include <cs/Text/PrintUtil.h>
+#include <cs/Text/StringUtil.h>
+
+#include "merge.h"
+
+#include "blockfile.h"
+
+////// Private ///////////////////////////////////////////////////////////////
+
+namespace impl_merge {
+
+  struct Source {
+    std::filesystem::path path;
+    std::time_t tim_begin{};
+    Block::id_stream_t id_stream{};
+  };
+
+  using CameraStream = std::pair<Toc::id_camera_t, std::size_t>;
+
+  struct Cursor {
+    std::unique_ptr<BlockFile> file;
+    Block block;
+    std::size_t index{};
+    bool is_overlapping{false};
+  };
+
+  struct CursorGreater {
+    bool operator()(const Cursor *a, const Cursor *b) const
+    {
+      if( a->block.timestamp != b->block.timestamp ) {
+        return a->block.timestamp > b->block.timestamp;
+      }
+      return a->index > b->index;
+    }
+  };
+
+  using CursorQueue = std::priority_queue<Cursor *, std::vector<Cursor *>, CursorGreater>;
+
+  Block seek(BlockFile *file, Block block,
+             const Block::id_stream_t id_stream, const FourCC& fourcc)
+  {
+    for( ; block.isValid(); block = file->next(block) ) {
+      if( block.id_stream == id_stream && block.fourcc == fourcc ) {
+        break;
+      }
+    }
+    return block;
+  }
+
+  void mergeCamera(const std::filesystem::path& output,
+                   const std::vector<Source>& sources, const FourCC& fourcc)
+  {
+    cs::File file;
+    if( !file.open(output, cs::FileOpenFlag::Write | cs::FileOpenFlag::Truncate) ) {
+      return;
+    }
+
+    // NOTE: Files are opened as soon as their time range begins and closed
+    //       as soon as their block chain is exhausted; only files actually
+    //       overlapping in time are kept open at the same time.
+
+    std::vector<Cursor> cursors(sources.size());
+    CursorQueue queue;
+
+    std::size_t pending = 0;
+    const auto activate = [&]() -> void {
+      while( pending < sources.size()
+             && (queue.empty() || sources[pending].tim_begin <= queue.top()->block.timestamp) ) {
+        Cursor& cursor = cursors[pending];
+        cursor.index   = pending;
+        cursor.file    = std::make_unique<BlockFile>();
+        if( cursor.file->open(sources[pending].path) ) {
+          cursor.file->findWrap();
+          cursor.block = seek(cursor.file.get(), cursor.file->first(),
+                              sources[pending].id_stream, fourcc);
+        }
+
+        if( cursor.block.isValid() ) {
+          queue.push(&cursor);
+        } else {
+          cursor.file.reset();
+        }
+
+        pending++;
+      }
+    };
+
+    // NOTE: Overlapping files record the same footage; once a block of
+    //       source S has been written, blocks of any other source are only
+    //       accepted if they are later. Blocks of the same second are only
+    //       accepted if S has been exhausted and the other source did not
+    //       overlap S before (i.e. a file boundary within a second).
+
+    std::time_t last_timestamp = 0;
+    const Cursor *last_cursor  = nullptr;
+
+    cs::Buffer data;
+    for( activate(); !queue.empty(); activate() ) {
+      Cursor *cursor = queue.top();
+      queue.pop();
+
+      const Block& block = cursor->block;
+
+      const bool is_duplicate = last_cursor != nullptr
+                                && last_cursor != cursor
+                                && (block.timestamp < last_timestamp
+                                    || (block.timestamp == last_timestamp
+                                        && (last_cursor->file || cursor->is_overlapping)));
+      if( is_duplicate ) {
+        cursor->is_overlapping = true;
+      } else if( cursor->file->readData(block, data) ) {
+        file.write(data.data(), data.size());
+
+        last_timestamp = block.timestamp;
+        last_cursor    = cursor;
+      }
+
+      cursor->block = seek(cursor->file.get(), cursor->file->next(block),
+                           sources[cursor->index].id_stream, fourcc);
+      if( cursor->block.isValid() ) {
+        queue.push(cursor);
+      } else {
+        cursor->file.reset();
+      }
+    }
+  }
+
+} // namespace impl_merge
+
+////// Public ////////////////////////////////////////////////////////////////
+
+void mergeCameras(const std::vector<std::filesystem::path>& inputs,
+                  const FourCC& fourcc)
+{
+  using Sources = std::vector<impl_merge::Source>;
+
+  if( inputs.empty() || isEmpty(fourcc) ) {
+    return;
+  }
+
+  // (1) Read TOCs ///////////////////////////////////////////////////////////
+
+  std::vector<std::pair<std::filesystem::path, Toc>> tocs;
+  for( const std::filesystem::path& input : inputs ) {
+    BlockFile file;
+    if( !file.open(input) ) {
+      fprintf(stderr, "ERROR: Unable to open file \"%s\"!\n", input.string().data());
+      continue;
+    }
+
+    const Toc toc = file.readToc();
+    if( !toc.isValid() ) {
+      fprintf(stderr, "ERROR: Invalid TOC in file \"%s\"!\n", input.string().data());
+      continue;
+    }
+
+    tocs.emplace_back(input, toc);
+  }
+
+  // (2) Map Streams to Cameras //////////////////////////////////////////////
+
+  // NOTE: A camera may record several streams at once (e.g. main and sub
+  //       stream); the n-th stream of a camera within a file is merged with
+  //       the n-th streams of the same camera of all other files.
+
+  std::map<impl_merge::CameraStream, Sources> cameras;
+  for( const auto& [path, toc] : tocs ) {
+    std::map<Toc::id_camera_t, std::size_t> numStreams;
+    for( std::size_t i = 0; i < Toc::NUM_STREAMS; i++ ) {
+      if( toc.id_stream[i] == 0 ) {
+        continue;
+      }
+
+      const impl_merge::CameraStream key(toc.id_camera[i], numStreams[toc.id_camera[i]]++);
+      cameras[key].push_back({path, toc.tim_stream_begin[i], toc.id_stream[i]});
+    }
+  }
+
+  // (3) Merge Cameras ///////////////////////////////////////////////////////
+
+  for( auto& [key, sources] : cameras ) {
+    const auto [id_camera, index] = key;
+
+    std::stable_sort(sources.begin(), sources.end(),
+                     [](const impl_merge::Source& a, const impl_merge::Source& b) -> bool {
+                       return a.tim_begin < b.tim_begin;
+                     });
+
+    const std::string output = index > 0
+                               ? cs::sprint("camera-%-%.%", id_camera, index, cs::toLower(toString(fourcc)))
+                               : cs::sprint("camera-%.%", id_camera, cs::toLower(toString(fourcc)));
+    impl_merge::mergeCamera(output, sources, fourcc);
+  }
+}
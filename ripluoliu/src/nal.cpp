@@ -0,0 +1,301 @@
+/****************************************************************************
+** Copyright (c) 2023, Carsten Schmidt. All rights reserved.
+**
+** Redistribution and use in source and binary forms, with or without
+** modification, are permitted provided that the following conditions
+** are met:
+**
+** 1. Redistributions of source code must retain the above copyright
+**    notice, this list of conditions and the following disclaimer.
+**
+** 2. Redistributions in binary form must reproduce the above copyright
+**    notice, this list of conditions and the following disclaimer in the
+**    documentation and/or other materials provided with the distribution.
+**
+** 3. Neither the name of the copyright holder nor the names of its
+**    contributors may be used to endorse or promote products derived from
+**    this software without specific prior written permission.
+**
+** THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+** "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+** LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+** A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+** HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+** SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+** LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+** DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+** THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+** (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+** OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*****************************************************************************/
+
+#if defined(__SSE2__) || defined(_M_X64)
+# include <emmintrin.h>
+# define HAVE_SSE2
+#endif
+
+#include <cstdio>
+
+#include <algorithm>
+
+#include "nal.h"
+
+////// Private ///////////////////////////////////////////////////////////////
+
+namespace impl_nal {
+
+  inline unsigned int countTrailingZeros(const unsigned int x)
+  {
+#if defined(_MSC_VER)
+    unsigned long index = 0;
+    _BitScanForward(&index, x);
+    return static_cast<unsigned int>(index);
+#else
+    return static_cast<unsigned int>(__builtin_ctz(x));
+#endif
+  }
+
+  inline bool isStartCode(const cs::byte_t *data)
+  {
+    return data[0] == 0 && data[1] == 0 && data[2] == 1;
+  }
+
+} // namespace impl_nal
+
+////// Public ////////////////////////////////////////////////////////////////
+
+NalCodec nalCodec(const FourCC& fourcc)
+{
+  const std::string_view s = toStringView(fourcc);
+  if( s == "H264" || s == "h264" || s == "AVC1" || s == "avc1" ) {
+    return NalCodec::H264;
+  } else if( s == "H265" || s == "h265" || s == "HEVC" || s == "hevc" || s == "HVC1" || s == "hvc1" ) {
+    return NalCodec::H265;
+  }
+  return NalCodec::None;
+}
+
+std::size_t findStartCode(const cs::byte_t *data, const std::size_t size,
+                          const std::size_t pos)
+{
+  if( size < 3 ) {
+    return size;
+  }
+
+  std::size_t i = pos;
+
+#ifdef HAVE_SSE2
+  // NOTE: Compare 16 candidate positions at once: data[i] == 0,
+  //       data[i + 1] == 0 and data[i + 2] == 1.
+  const __m128i zero = _mm_setzero_si128();
+  const __m128i one  = _mm_set1_epi8(1);
+  for( ; i + 18 <= size; i += 16 ) {
+    const __m128i b0 = _mm_loadu_si128(reinterpret_cast<const __m128i *>(data + i));
+    const __m128i b1 = _mm_loadu_si128(reinterpret_cast<const __m128i *>(data + i + 1));
+    const __m128i b2 = _mm_loadu_si128(reinterpret_cast<const __m128i *>(data + i + 2));
+
+    const __m128i m = _mm_and_si128(_mm_and_si128(_mm_cmpeq_epi8(b0, zero),
+                                                  _mm_cmpeq_epi8(b1, zero)),
+                                    _mm_cmpeq_epi8(b2, one));
+
+    const unsigned int mask = static_cast<unsigned int>(_mm_movemask_epi8(m));
+    if( mask != 0 ) {
+      return i + impl_nal::countTrailingZeros(mask);
+    }
+  }
+#endif
+
+  for( ; i + 3 <= size; i++ ) {
+    if( impl_nal::isStartCode(data + i) ) {
+      return i;
+    }
+  }
+
+  return size;
+}
+
+const char *nalTypeName(const NalCodec codec, const uint8_t type)
+{
+  if( codec == NalCodec::H264 ) {
+    switch( type ) {
+    case 1:
+      return "SLICE";
+    case 5:
+      return "IDR";
+    case 6:
+      return "SEI";
+    case 7:
+      return "SPS";
+    case 8:
+      return "PPS";
+    case 9:
+      return "AUD";
+    default:
+      break;
+    }
+  } else if( codec == NalCodec::H265 ) {
+    if( type <= 9 ) {
+      return "SLICE";
+    } else if( type == 19 || type == 20 ) {
+      return "IDR";
+    } else if( type >= 16 && type <= 21 ) {
+      return "IRAP";
+    }
+    switch( type ) {
+    case 32:
+      return "VPS";
+    case 33:
+      return "SPS";
+    case 34:
+      return "PPS";
+    case 35:
+      return "AUD";
+    case 39:
+    case 40:
+      return "SEI";
+    default:
+      break;
+    }
+  }
+  return "OTHER";
+}
+
+bool hasKeyFrame(const NalCodec codec,
+                 const cs::byte_t *data, const std::size_t size,
+                 const bool is_key)
+{
+  bool has_key = false;
+  const std::size_t numNals = scanNals(codec, data, size, [&](const Nal& nal) -> void {
+    has_key = has_key || nal.is_key;
+  });
+
+  return numNals > 0
+         ? has_key
+         : is_key;
+}
+
+////// NalSink - public //////////////////////////////////////////////////////
+
+NalSink::~NalSink() noexcept
+{
+}
+
+void NalSink::write(const Block& block,
+                    const cs::byte_t *data, const std::size_t size)
+{
+  // (1) Scan ////////////////////////////////////////////////////////////////
+
+  _nals.clear();
+  scanNals(_codec, data, size, [&](const Nal& nal) -> void {
+    _nals.push_back(nal);
+  });
+
+  bool has_broken = false;
+  bool has_key    = false;
+  for( const Nal& nal : _nals ) {
+    has_broken = has_broken || nal.is_broken;
+    has_key    = has_key || nal.is_key;
+  }
+
+  // (2) Correct Key Frame Flag //////////////////////////////////////////////
+
+  Block corrected = block;
+  if( !_nals.empty() ) {
+    corrected.is_key = has_key;
+  }
+
+  if( _key_only && !corrected.is_key ) {
+    return;
+  }
+
+  // (3) Pass On /////////////////////////////////////////////////////////////
+
+  const std::size_t offset = _offset; // of this block's output
+
+  if( !has_broken || !_drop_broken ) {
+    _sink->write(corrected, data, size);
+    _offset += size;
+
+  } else {
+    // NOTE: Each NAL unit is passed on together with the bytes preceding it,
+    //       i.e. its start code including any leading zeros.
+    std::size_t begin = 0;
+    for( std::size_t i = 0; i < _nals.size(); i++ ) {
+      Nal& nal              = _nals[i];
+      const std::size_t end = i + 1 < _nals.size()
+                              ? nal.offset + nal.size
+                              : size;
+
+      if( !nal.is_broken ) {
+        _sink->write(corrected, data + begin, end - begin);
+
+        nal.offset  = _offset - offset + nal.offset - begin;
+        _offset    += end - begin;
+      }
+
+      begin = end;
+    }
+  }
+
+  // (4) Index ///////////////////////////////////////////////////////////////
+
+  if( !_index.isOpen() ) {
+    return;
+  }
+
+  for( const Nal& nal : _nals ) {
+    if( nal.is_broken && _drop_broken ) {
+      continue;
+    }
+
+    // NOTE: Formatted in place; this runs for every NAL unit.
+    char line[80];
+    const int length = snprintf(line, sizeof(line), "%zu %zu %d %s\n",
+                                offset + nal.offset, nal.size,
+                                nal.is_broken ? -1 : static_cast<int>(nal.type),
+                                nal.is_broken ? "BROKEN" : nalTypeName(_codec, nal.type));
+    if( length > 0 ) {
+      _index.write(line, std::min<std::size_t>(length, sizeof(line) - 1));
+    }
+  }
+}
+
+void NalSink::close()
+{
+  _sink->close();
+  _index.close();
+}
+
+bool NalSink::checksKeyFrames() const
+{
+  return _key_only;
+}
+
+SinkPtr NalSink::make(SinkPtr sink, const NalCodec codec,
+                      const std::filesystem::path& index, const bool drop_broken,
+                      const bool key_only)
+{
+  if( !sink ) {
+    return SinkPtr();
+  }
+
+  std::unique_ptr<NalSink> nalSink(new NalSink());
+  if( !index.empty()
+      && !nalSink->_index.open(index, cs::FileOpenFlag::Write | cs::FileOpenFlag::Truncate) ) {
+    return SinkPtr();
+  }
+
+  nalSink->_sink        = std::move(sink);
+  nalSink->_codec       = codec;
+  nalSink->_drop_broken = drop_broken;
+  nalSink->_key_only    = key_only;
+  nalSink->_nals.reserve(NUM_NALS_RESERVED);
+
+  return nalSink;
+}
+
+////// NalSink - private /////////////////////////////////////////////////////
+
+NalSink::NalSink() noexcept
+{
+}
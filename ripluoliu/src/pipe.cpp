@@ -0,0 +1,207 @@
+/****************************************************************************
+** Copyright (c) 2023, Carsten Schmidt. All rights reserved.
+**
+** Redistribution and use in source and binary forms, with or without
+** modification, are permitted provided that the following conditions
+** are met:
+**
+** 1. Redistributions of source code must retain the above copyright
+**    notice, this list of conditions and the following disclaimer.
+**
+** 2. Redistributions in binary form must reproduce the above copyright
+**    notice, this list of conditions and the following disclaimer in the
+**    documentation and/or other materials provided with the distribution.
+**
+** 3. Neither the name of the copyright holder nor the names of its
+**    contributors may be used to endorse or promote products derived from
+**    this software without specific prior written permission.
+**
+** THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+** "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+** LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+** A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+** HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+** SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+** LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+** DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+** THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+** (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+** OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*****************************************************************************/
+
+#include <cerrno>
+#include <csignal>
+#include <cstdio>
+
+#ifndef _WIN32
+# include <fcntl.h>
+# include <sys/stat.h>
+# include <unistd.h>
+#endif
+
+#include <chrono>
+
+#include "pipe.h"
+
+////// Private ///////////////////////////////////////////////////////////////
+
+namespace impl_pipe {
+
+#ifndef _WIN32
+  bool writeAll(const int fd, const cs::byte_t *data, std::size_t size)
+  {
+    while( size > 0 ) {
+      const ssize_t numWritten = ::write(fd, data, size);
+      if( numWritten < 0 && errno == EINTR ) {
+        continue;
+      } else if( numWritten <= 0 ) {
+        return false;
+      }
+
+      data += numWritten;
+      size -= static_cast<std::size_t>(numWritten);
+    }
+    return true;
+  }
+#endif
+
+} // namespace impl_pipe
+
+////// public ////////////////////////////////////////////////////////////////
+
+PipeSink::~PipeSink() noexcept
+{
+  close();
+
+  if( _thread.joinable() ) {
+    _thread.join();
+  }
+}
+
+void PipeSink::write(const Block& /*block*/,
+                     const cs::byte_t *data, const std::size_t size)
+{
+  std::lock_guard<std::mutex> lock(_mutex);
+  if( _is_broken || _is_closed || size == 0 ) {
+    return;
+  }
+
+  _queue.push_back({data, size});
+  _cond_data.notify_one();
+}
+
+void PipeSink::close()
+{
+  {
+    std::lock_guard<std::mutex> lock(_mutex);
+    _is_closed = true;
+  }
+  _cond_data.notify_one();
+}
+
+SinkPtr PipeSink::make(const std::filesystem::path& fifo)
+{
+#ifdef _WIN32
+  fprintf(stderr, "ERROR: Pipes are not supported on this platform!\n");
+  return SinkPtr();
+#else
+  if( !fifo.empty() ) {
+    std::error_code ec;
+    if( !std::filesystem::is_fifo(fifo, ec) && ::mkfifo(fifo.c_str(), 0644) != 0 ) {
+      fprintf(stderr, "ERROR: Unable to create FIFO \"%s\"!\n", fifo.c_str());
+      return SinkPtr();
+    }
+  }
+
+  std::signal(SIGPIPE, SIG_IGN);
+
+  std::unique_ptr<PipeSink> sink(new PipeSink());
+  sink->_fifo   = fifo;
+  sink->_thread = std::thread(&PipeSink::work, sink.get());
+
+  return sink;
+#endif
+}
+
+////// private ///////////////////////////////////////////////////////////////
+
+PipeSink::PipeSink() noexcept
+{
+}
+
+int PipeSink::openFifo()
+{
+#ifndef _WIN32
+  using Clock = std::chrono::steady_clock;
+
+  constexpr auto INTERVAL_OPEN = std::chrono::milliseconds(100);
+
+  // NOTE: A blocking open() waits for a reader indefinitely; without a
+  //       reader, a non-blocking open() fails with ENXIO and is retried.
+  Clock::time_point tim_closed;
+  for( bool is_closed = false;; ) {
+    const int fd = ::open(_fifo.c_str(), O_WRONLY | O_NONBLOCK | O_CLOEXEC);
+    if( fd >= 0 ) {
+      ::fcntl(fd, F_SETFL, ::fcntl(fd, F_GETFL) & ~O_NONBLOCK);
+      return fd;
+    } else if( errno != ENXIO && errno != EINTR ) {
+      fprintf(stderr, "ERROR: Unable to open FIFO \"%s\"!\n", _fifo.c_str());
+      return -1;
+    }
+
+    std::unique_lock<std::mutex> lock(_mutex);
+    if( !is_closed && _is_closed ) {
+      is_closed  = true;
+      tim_closed = Clock::now();
+    }
+
+    if( is_closed && Clock::now() - tim_closed >= std::chrono::seconds(TIMEOUT_OPEN_S) ) {
+      fprintf(stderr, "ERROR: No reader opened FIFO \"%s\"; skipping!\n", _fifo.c_str());
+      return -1;
+    }
+
+    _cond_data.wait_for(lock, INTERVAL_OPEN, [&]() -> bool {
+      return _is_closed && !is_closed;
+    });
+  }
+#else
+  return -1;
+#endif
+}
+
+void PipeSink::work()
+{
+#ifndef _WIN32
+  const int fd = _fifo.empty()
+                 ? STDOUT_FILENO
+                 : openFifo();
+
+  for( bool is_ok = fd >= 0;; ) {
+    Span span;
+    {
+      std::unique_lock<std::mutex> lock(_mutex);
+      if( !is_ok && !_is_broken ) {
+        _is_broken = true;
+        _queue.clear();
+      }
+
+      _cond_data.wait(lock, [this]() -> bool {
+        return _is_closed || !_queue.empty();
+      });
+
+      if( _queue.empty() ) {
+        break;
+      }
+
+      span = _queue.front();
+      _queue.pop_front();
+    }
+
+    is_ok = impl_pipe::writeAll(fd, span.data, span.size);
+  }
+
+  if( fd >= 0 && fd != STDOUT_FILENO ) {
+    ::close(fd);
+  }
+#endif
+}
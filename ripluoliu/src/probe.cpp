@@ -0,0 +1,134 @@
+/****************************************************************************
+** Copyright (c) 2023, Carsten Schmidt. All rights reserved.
+**
+** Redistribution and use in source and binary forms, with or without
+** modification, are permitted provided that the following conditions
+** are met:
+**
+** 1. Redistributions of source code must retain the above copyright
+**    notice, this list of conditions and the following disclaimer.
+**
+** 2. Redistributions in binary form must reproduce the above copyright
+**    notice, this list of conditions and the following disclaimer in the
+**    documentation and/or other materials provided with the distribution.
+**
+** 3. Neither the name of the copyright holder nor the names of its
+**    contributors may be used to endorse or promote products derived from
+**    this software without specific prior written permission.
+**
+** THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+** "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+** LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+** A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+** HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+** SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+** LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+** DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+** THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+** (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+** OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*****************************************************************************/
+
+#include <algorithm>
+
+#include <cs/Text/PrintUtil.h>
+
+#include "probe.h"
+
+#include "blockfile.h"
+#include "util.h"
+
+////// public ////////////////////////////////////////////////////////////////
+
+Probe::Probe() noexcept
+{
+}
+
+bool Probe::isValid() const
+{
+  return toc.isValid() && block.isValid() && block.id_stream != 0;
+}
+
+void Probe::print(std::ostream *stream) const
+{
+  if( !isValid() ) {
+    cs::println(stream, "%: invalid", path.string());
+    return;
+  }
+
+  std::size_t numStreams = 0;
+  std::vector<Toc::id_camera_t> cameras;
+  for( std::size_t i = 0; i < Toc::NUM_STREAMS; i++ ) {
+    if( toc.id_stream[i] == 0 ) {
+      continue;
+    }
+
+    numStreams++;
+    if( std::find(cameras.begin(), cameras.end(), toc.id_camera[i]) == cameras.end() ) {
+      cameras.push_back(toc.id_camera[i]);
+    }
+  }
+  std::sort(cameras.begin(), cameras.end());
+
+  std::string listCameras;
+  for( const Toc::id_camera_t id_camera : cameras ) {
+    listCameras += listCameras.empty()
+                   ? cs::sprint("%", id_camera)
+                   : cs::sprint(",%", id_camera);
+  }
+
+  cs::println(stream, "%: valid streams=% cameras=% time=%..%",
+              path.string(), numStreams, listCameras,
+              formatTime(toc.tim_begin), formatTime(toc.tim_end));
+}
+
+////// public static /////////////////////////////////////////////////////////
+
+Probe Probe::read(const std::filesystem::path& path)
+{
+  Probe probe;
+  probe.path = path;
+
+  BlockFile file;
+  if( !file.open(path) ) {
+    return probe;
+  }
+
+  probe.toc = file.readToc();
+  if( probe.toc.isValid() ) {
+    probe.block = file.readBlock(Toc::SIZE_TOC);
+  }
+
+  return probe;
+}
+
+////// Public ////////////////////////////////////////////////////////////////
+
+std::vector<Probe> probeFiles(const std::vector<std::filesystem::path>& inputs)
+{
+  std::vector<Probe> probes;
+
+  // (1) List Files //////////////////////////////////////////////////////////
+
+  for( const std::filesystem::path& input : inputs ) {
+    std::error_code ec;
+    if( !std::filesystem::is_directory(input, ec) ) {
+      probes.emplace_back().path = input;
+      continue;
+    }
+
+    walkDirectory(input, [&](const std::filesystem::directory_entry& entry) -> void {
+      if( entry.is_regular_file(ec) ) {
+        probes.emplace_back().path = entry.path();
+      }
+    });
+  }
+
+  // (2) Probe ///////////////////////////////////////////////////////////////
+
+  parallelFor(probes.size(), [&](const std::size_t i) -> void {
+    probes[i] = Probe::read(probes[i].path);
+  });
+
+  return probes;
+}
@@ -0,0 +1,273 @@
+/****************************************************************************
+** Copyright (c) 2023, Carsten Schmidt. All rights reserved.
+**
+** Redistribution and use in source and binary forms, with or without
+** modification, are permitted provided that the following conditions
+** are met:
+**
+** 1. Redistributions of source code must retain the above copyright
+**    notice, this list of conditions and the following disclaimer.
+**
+** 2. Redistributions in binary form must reproduce the above copyright
+**    notice, this list of conditions and the following disclaimer in the
+**    documentation and/or other materials provided with the distribution.
+**
+** 3. Neither the name of the copyright holder nor the names of its
+**    contributors may be used to endorse or promote products derived from
+**    this software without specific prior written permission.
+**
+** THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+** "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+** LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+** A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+** HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+** SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+** LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+** DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+** THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+** (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+** OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*****************************************************************************/
+
+#include <cstdio>
+
+#include <algorithm>
+#include <limits>
+#include <vector>
+
+#ifdef __linux__
+# include <fcntl.h>
+# include <unistd.h>
+#endif
+
+#include <cs/IO/File.h>
+
+#include "repack.h"
+
+#include "blockfile.h"
+#include "nal.h"
+
+////// Private ///////////////////////////////////////////////////////////////
+
+namespace impl_repack {
+
+  struct Run {
+    std::size_t offset{};
+    std::size_t size{};
+  };
+
+  bool writeToc(const std::filesystem::path& output, const cs::Buffer& bytesToc)
+  {
+    cs::File file;
+    return file.open(output, cs::FileOpenFlag::Write | cs::FileOpenFlag::Truncate)
+           && file.write(bytesToc.data(), bytesToc.size()) == bytesToc.size();
+  }
+
+  bool copyBuffered(const std::filesystem::path& input, const std::filesystem::path& output,
+                    const cs::Buffer& bytesToc, const std::vector<Run>& runs)
+  {
+    constexpr std::size_t SIZE_CHUNK = 0x100000;
+
+    cs::File in;
+    cs::File out;
+    if( !in.open(input)
+        || !out.open(output, cs::FileOpenFlag::Write | cs::FileOpenFlag::Truncate)
+        || out.write(bytesToc.data(), bytesToc.size()) != bytesToc.size() ) {
+      return false;
+    }
+
+    cs::Buffer chunk(SIZE_CHUNK);
+    for( const Run& run : runs ) {
+      if( !in.seek(run.offset) ) {
+        return false;
+      }
+
+      for( std::size_t pos = 0; pos < run.size; ) {
+        const std::size_t count = std::min(run.size - pos, chunk.size());
+        if( in.read(chunk.data(), count) != count
+            || out.write(chunk.data(), count) != count ) {
+          return false;
+        }
+        pos += count;
+      }
+    }
+
+    return true;
+  }
+
+#ifdef __linux__
+  // NOTE: copy_file_range() copies in-kernel; file systems supporting
+  //       reflinks do not even copy the data.
+  bool copyRuns(const std::filesystem::path& input, const std::filesystem::path& output,
+                const std::size_t offset, const std::vector<Run>& runs)
+  {
+    const int fd_in = ::open(input.c_str(), O_RDONLY);
+    if( fd_in < 0 ) {
+      return false;
+    }
+
+    const int fd_out = ::open(output.c_str(), O_WRONLY);
+    if( fd_out < 0 ) {
+      ::close(fd_in);
+      return false;
+    }
+
+    bool is_ok     = true;
+    loff_t off_out = static_cast<loff_t>(offset);
+    for( const Run& run : runs ) {
+      loff_t off_in = static_cast<loff_t>(run.offset);
+      for( std::size_t remain = run.size; is_ok && remain > 0; ) {
+        const ssize_t numCopied = ::copy_file_range(fd_in, &off_in, fd_out, &off_out, remain, 0);
+        is_ok   = numCopied > 0;
+        remain -= is_ok ? static_cast<std::size_t>(numCopied) : 0;
+      }
+    }
+
+    ::close(fd_out);
+    ::close(fd_in);
+
+    return is_ok;
+  }
+#endif
+
+} // namespace impl_repack
+
+////// Public ////////////////////////////////////////////////////////////////
+
+long long repackFile(const std::filesystem::path& input,
+                     const std::filesystem::path& output,
+                     const Filter& filter)
+{
+  using namespace impl_repack;
+
+  std::error_code ec;
+  if( std::filesystem::equivalent(input, output, ec) ) {
+    fprintf(stderr, "ERROR: Output \"%s\" is the input file!\n", output.string().data());
+    return -1;
+  }
+
+  BlockFile file;
+  if( !file.open(input) ) {
+    return -1;
+  }
+
+  // (1) Source TOC //////////////////////////////////////////////////////////
+
+  cs::Buffer bytesToc(Toc::SIZE_TOC);
+  if( file.read(0, bytesToc.data(), bytesToc.size()) != bytesToc.size() ) {
+    return -1;
+  }
+
+  const Toc source = Toc::read(bytesToc);
+  if( !source.isValid() ) {
+    return -1;
+  }
+
+  // (2) Select Blocks & Compute TOC /////////////////////////////////////////
+
+  Toc toc       = source;
+  toc.tim_begin = std::numeric_limits<std::time_t>::max();
+  toc.tim_end   = 0;
+  toc.num_blocks.fill(0);
+  toc.siz_stream.fill(0);
+
+  std::vector<Run> runs;
+  cs::Buffer payload;
+  long long numBlocks = 0;
+  file.findWrap();
+  for( Block block = file.first(); block.isValid(); block = file.next(block) ) {
+    const auto slot = std::find(source.id_stream.begin(), source.id_stream.end(), block.id_stream);
+    if( block.id_stream == 0 || slot == source.id_stream.end() ) {
+      continue;
+    }
+
+    // NOTE: As for extraction, key frames of H.264/H.265 are determined from
+    //       the NAL units, since the header's key frame flag is not reliable;
+    //       only payloads passing all other predicates are scanned.
+    const NalCodec codec   = nalCodec(block.fourcc);
+    const bool is_scanning = filter.is_key_only && codec != NalCodec::None;
+    Block candidate        = block;
+    candidate.is_key       = candidate.is_key || is_scanning;
+
+    const std::size_t i = slot - source.id_stream.begin();
+    if( !filter.accepts(candidate, source.id_camera[i]) ) {
+      continue;
+    }
+
+    if( is_scanning
+        && (!file.readData(block, payload)
+            || !hasKeyFrame(codec, payload.data(), payload.size(), block.is_key)) ) {
+      continue;
+    }
+
+    // NOTE: siz_stream accumulates the payload sizes.
+    if( toc.num_blocks[i] == 0 ) {
+      toc.tim_stream_begin[i] = block.timestamp;
+      toc.tim_stream_end1[i]  = block.timestamp;
+    }
+    toc.num_blocks[i]++;
+    toc.siz_stream[i]       += block.block_size;
+    toc.tim_stream_begin[i]  = std::min(toc.tim_stream_begin[i], block.timestamp);
+    toc.tim_stream_end1[i]   = std::max(toc.tim_stream_end1[i], block.timestamp);
+    toc.tim_stream_end2[i]   = toc.tim_stream_end1[i];
+
+    toc.tim_begin = std::min(toc.tim_begin, block.timestamp);
+    toc.tim_end   = std::max(toc.tim_end, block.timestamp);
+
+    const std::size_t size = block.next() - block.offset;
+    if( !runs.empty() && runs.back().offset + runs.back().size == block.offset ) {
+      runs.back().size += size;
+    } else {
+      runs.push_back({block.offset, size});
+    }
+    numBlocks++;
+  }
+
+  for( std::size_t i = 0; i < Toc::NUM_STREAMS; i++ ) {
+    if( toc.num_blocks[i] > 0 ) {
+      continue;
+    }
+
+    toc.id_stream[i]        = 0;
+    toc.id_camera[i]        = 0;
+    toc.tim_stream_begin[i] = 0;
+    toc.tim_stream_end1[i]  = 0;
+    toc.tim_stream_end2[i]  = 0;
+  }
+
+  if( numBlocks == 0 ) {
+    toc.tim_begin = toc.tim_end = 0;
+  }
+
+  toc.write(bytesToc);
+
+  // (3) Write TOC & Copy Blocks ////////////////////////////////////////////
+
+  // NOTE: The output is written to a temporary file next to it and renamed
+  //       once complete; a failure never leaves a partial file behind.
+  std::filesystem::path temp = output;
+  temp += ".tmp";
+
+  bool is_copied = false;
+#ifdef __linux__
+  is_copied = writeToc(temp, bytesToc) && copyRuns(input, temp, Toc::SIZE_TOC, runs);
+#endif
+
+  // NOTE: Fall back to copying via user space, e.g. across file systems on
+  //       older kernels.
+  if( !is_copied ) {
+    is_copied = copyBuffered(input, temp, bytesToc, runs);
+  }
+
+  if( is_copied ) {
+    std::filesystem::rename(temp, output, ec);
+    is_copied = !ec;
+  }
+
+  if( !is_copied ) {
+    std::filesystem::remove(temp, ec);
+    return -1;
+  }
+
+  return numBlocks;
+}
@@ -0,0 +1,362 @@
+/****************************************************************************
+** Copyright (c) 2023, Carsten Schmidt. All rights reserved.
+**
+** Redistribution and use in source and binary forms, with or without
+** modification, are permitted provided that the following conditions
+** are met:
+**
+** 1. Redistributions of source code must retain the above copyright
+**    notice, this list of conditions and the following disclaimer.
+**
+** 2. Redistributions in binary form must reproduce the above copyright
+**    notice, this list of conditions and the following disclaimer in the
+**    documentation and/or other materials provided with the distribution.
+**
+** 3. Neither the name of the copyright holder nor the names of its
+**    contributors may be used to endorse or promote products derived from
+**    this software without specific prior written permission.
+**
+** THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+** "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+** LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+** A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+** HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+** SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+** LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+** DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+** THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+** (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+** OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*****************************************************************************/
+
+#include <cstdio>
+
+#include <algorithm>
+#include <bit>
+#include <cmath>
+#include <limits>
+#include <string>
+#include <string_view>
+
+#include <cs/Text/PrintFormat.h>
+#include <cs/Text/PrintUtil.h>
+
+#include "report.h"
+
+#include "blockfile.h"
+
+#include "util.h"
+
+////// Private ///////////////////////////////////////////////////////////////
+
+namespace impl_report {
+
+  constexpr std::size_t MIN_OUTLIER_SAMPLES = 100;
+  constexpr double OUTLIER_SIGMAS           = 4;
+
+  inline bool hasValue(const uint32_t x)
+  {
+    return x != std::numeric_limits<uint32_t>::max();
+  }
+
+  inline std::string formatDouble(const double x)
+  {
+    char str[32];
+    std::snprintf(str, sizeof(str), "%.2f", x);
+    return std::string(str);
+  }
+
+  // NOTE: FourCCs are read from the file and may hold any byte.
+  std::string jsonString(const std::string_view s)
+  {
+    std::string result("\"");
+    for( const char c : s ) {
+      if( c == '"' || c == '\\' ) {
+        result += '\\';
+        result += c;
+      } else if( static_cast<unsigned char>(c) < 0x20 || static_cast<unsigned char>(c) >= 0x7F ) {
+        char escaped[8];
+        std::snprintf(escaped, sizeof(escaped), "\\u%04X", static_cast<unsigned char>(c));
+        result += escaped;
+      } else {
+        result += c;
+      }
+    }
+    result += '"';
+    return result;
+  }
+
+} // namespace impl_report
+
+////// Stream - public ///////////////////////////////////////////////////////
+
+void Report::Stream::add(const Block& block)
+{
+  const std::size_t size = block.block_size;
+
+  // (1) Continuity //////////////////////////////////////////////////////////
+
+  std::time_t gap = 0; // seconds w/o any block
+
+  if( num_blocks == 0 ) {
+    tim_first       = block.timestamp;
+    tim_last        = block.timestamp;
+    tim_window      = block.timestamp;
+    tim_window_last = block.timestamp;
+    vid_width       = block.vid_width;
+    vid_height      = block.vid_height;
+
+  } else {
+    const std::time_t delta = block.timestamp - tim_last;
+    if( delta > GAP ) {
+      gap = delta - 1;
+
+      num_gaps++;
+      tim_gaps += gap;
+      if( gap > max_gap ) {
+        max_gap     = gap;
+        tim_max_gap = tim_last;
+      }
+    }
+
+    if( block.vid_width != vid_width || block.vid_height != vid_height ) {
+      vid_width  = block.vid_width;
+      vid_height = block.vid_height;
+      num_resolution_changes++;
+    }
+
+    tim_last = std::max(tim_last, block.timestamp);
+  }
+
+  // (2) Windows /////////////////////////////////////////////////////////////
+
+  if( block.timestamp >= tim_window + WINDOW ) {
+    closeWindow();
+    tim_window      = block.timestamp;
+    tim_window_last = block.timestamp;
+  } else {
+    window_gaps += gap;
+  }
+
+  window_bytes    += size;
+  tim_window_last  = std::max(tim_window_last, block.timestamp);
+  window_blocks++;
+
+  // (3) Block Size //////////////////////////////////////////////////////////
+
+  const double delta = static_cast<double>(size) - mean_size;
+  if( num_blocks >= impl_report::MIN_OUTLIER_SAMPLES
+      && std::abs(delta) > impl_report::OUTLIER_SIGMAS * stddevSize() ) {
+    num_outliers++;
+  }
+
+  mean_size += delta / static_cast<double>(num_blocks + 1);
+  m2_size   += delta * (static_cast<double>(size) - mean_size);
+  max_size   = std::max(max_size, size);
+  histogram[std::bit_width(size) % NUM_BINS]++;
+
+  // (4) Totals //////////////////////////////////////////////////////////////
+
+  id_camera  = block.id_camera;
+  vid_fps    = block.vid_fps;
+  num_blocks++;
+  num_keys  += block.is_key ? 1 : 0;
+  num_bytes += size;
+}
+
+void Report::Stream::finish()
+{
+  if( window_blocks > 0 ) {
+    closeWindow();
+  }
+}
+
+std::time_t Report::Stream::duration() const
+{
+  return num_blocks > 0
+         ? std::max<std::time_t>(tim_last - tim_first + 1 - tim_gaps, 1)
+         : 0;
+}
+
+double Report::Stream::bitrate() const
+{
+  return num_blocks > 0
+         ? static_cast<double>(num_bytes) * 8 / static_cast<double>(duration())
+         : 0;
+}
+
+double Report::Stream::fps() const
+{
+  return num_blocks > 0
+         ? static_cast<double>(num_blocks) / static_cast<double>(duration())
+         : 0;
+}
+
+double Report::Stream::stddevSize() const
+{
+  return num_blocks > 1
+         ? std::sqrt(m2_size / static_cast<double>(num_blocks - 1))
+         : 0;
+}
+
+////// Stream - private //////////////////////////////////////////////////////
+
+void Report::Stream::closeWindow()
+{
+  // NOTE: The seconds covered by blocks, i.e. w/o gaps and w/o the time after
+  //       the window's last block.
+  const std::time_t duration = std::clamp<std::time_t>(tim_window_last - tim_window + 1 - window_gaps,
+                                                       1, WINDOW);
+
+  const double bitrate = static_cast<double>(window_bytes) * 8 / static_cast<double>(duration);
+  const double fps     = static_cast<double>(window_blocks) / static_cast<double>(duration);
+
+  min_bitrate = num_windows > 0 ? std::min(min_bitrate, bitrate) : bitrate;
+  max_bitrate = num_windows > 0 ? std::max(max_bitrate, bitrate) : bitrate;
+  min_fps     = num_windows > 0 ? std::min(min_fps, fps) : fps;
+  max_fps     = num_windows > 0 ? std::max(max_fps, fps) : fps;
+
+  num_windows++;
+  window_bytes  = 0;
+  window_blocks = 0;
+  window_gaps   = 0;
+}
+
+////// public ////////////////////////////////////////////////////////////////
+
+Report::Report() noexcept
+{
+}
+
+void Report::add(const Block& block)
+{
+  for( std::size_t i = 0; i < _num_streams; i++ ) {
+    if( _streams[i].id_stream == block.id_stream && _streams[i].fourcc == block.fourcc ) {
+      _streams[i].add(block);
+      return;
+    }
+  }
+
+  if( _num_streams >= MAX_STREAMS ) {
+    _num_ignored++;
+    return;
+  }
+
+  Stream& stream   = _streams[_num_streams++];
+  stream.id_stream = block.id_stream;
+  stream.fourcc    = block.fourcc;
+  stream.add(block);
+}
+
+void Report::finish()
+{
+  for( std::size_t i = 0; i < _num_streams; i++ ) {
+    _streams[i].finish();
+  }
+}
+
+void Report::print(std::ostream *stream) const
+{
+  using namespace impl_report;
+
+  for( std::size_t i = 0; i < _num_streams; i++ ) {
+    const Stream& s = _streams[i];
+
+    cs::println(stream, "id_stream   = 0x%", cs::hexf(s.id_stream, true));
+    cs::println(stream, "fourcc      = %", toStringView(s.fourcc));
+    cs::println(stream, "id_camera   = %", s.id_camera);
+    cs::println(stream, "blocks      = % (keys %)", s.num_blocks, s.num_keys);
+    cs::println(stream, "bytes       = %", s.num_bytes);
+    cs::println(stream, "time        = % - %", formatTime(s.tim_first), formatTime(s.tim_last));
+    cs::println(stream, "bitrate     = % bit/s (window min % max %)",
+                formatDouble(s.bitrate()), formatDouble(s.min_bitrate), formatDouble(s.max_bitrate));
+    if( hasValue(s.vid_fps) ) {
+      cs::println(stream, "fps         = % (nominal %, window min % max %)",
+                  formatDouble(s.fps()), s.vid_fps, formatDouble(s.min_fps), formatDouble(s.max_fps));
+    } else {
+      cs::println(stream, "fps         = % (window min % max %)",
+                  formatDouble(s.fps()), formatDouble(s.min_fps), formatDouble(s.max_fps));
+    }
+    cs::println(stream, "gaps        = % (total % s, max % s at %)",
+                s.num_gaps, s.tim_gaps, s.max_gap, s.num_gaps > 0 ? formatTime(s.tim_max_gap) : std::string("-"));
+    if( hasValue(s.vid_width) && hasValue(s.vid_height) ) {
+      cs::println(stream, "resolution  = %x% (% changes)", s.vid_width, s.vid_height, s.num_resolution_changes);
+    }
+    cs::println(stream, "block_size  = mean % stddev % max % (outliers %)",
+                formatDouble(s.mean_size), formatDouble(s.stddevSize()), s.max_size, s.num_outliers);
+    cs::println(stream, "");
+  }
+
+  if( _num_ignored > 0 ) {
+    cs::println(stream, "WARNING: Ignored % blocks of excess streams!", _num_ignored);
+  }
+}
+
+void Report::printJson(std::ostream *stream) const
+{
+  using namespace impl_report;
+
+  cs::println(stream, "{");
+  cs::println(stream, "  \"ignored_blocks\": %,", _num_ignored);
+  cs::println(stream, "  \"streams\": [");
+  for( std::size_t i = 0; i < _num_streams; i++ ) {
+    const Stream& s = _streams[i];
+
+    std::string histogram;
+    for( std::size_t bin = 0; bin < NUM_BINS; bin++ ) {
+      histogram += cs::sprint(bin > 0 ? ", %" : "%", s.histogram[bin]);
+    }
+
+    cs::println(stream, "    {");
+    cs::println(stream, "      \"id_stream\": %,", s.id_stream);
+    cs::println(stream, "      \"fourcc\": %,", jsonString(toStringView(s.fourcc)));
+    cs::println(stream, "      \"id_camera\": %,", s.id_camera);
+    cs::println(stream, "      \"blocks\": %,", s.num_blocks);
+    cs::println(stream, "      \"keys\": %,", s.num_keys);
+    cs::println(stream, "      \"bytes\": %,", s.num_bytes);
+    cs::println(stream, "      \"time_first\": %,", s.tim_first);
+    cs::println(stream, "      \"time_last\": %,", s.tim_last);
+    cs::println(stream, "      \"bitrate\": { \"mean\": %, \"min\": %, \"max\": % },",
+                formatDouble(s.bitrate()), formatDouble(s.min_bitrate), formatDouble(s.max_bitrate));
+    cs::println(stream, "      \"fps\": { \"mean\": %, \"nominal\": %, \"min\": %, \"max\": % },",
+                formatDouble(s.fps()), hasValue(s.vid_fps) ? cs::sprint("%", s.vid_fps) : std::string("null"),
+                formatDouble(s.min_fps), formatDouble(s.max_fps));
+    cs::println(stream, "      \"gaps\": { \"count\": %, \"total\": %, \"max\": %, \"time_max\": % },",
+                s.num_gaps, s.tim_gaps, s.max_gap, s.num_gaps > 0 ? cs::sprint("%", s.tim_max_gap) : std::string("null"));
+    cs::println(stream, "      \"resolution\": { \"width\": %, \"height\": %, \"changes\": % },",
+                s.vid_width, s.vid_height, s.num_resolution_changes);
+    cs::println(stream, "      \"block_size\": { \"mean\": %, \"stddev\": %, \"max\": %, \"outliers\": %, \"log2_histogram\": [%] }",
+                formatDouble(s.mean_size), formatDouble(s.stddevSize()), s.max_size, s.num_outliers, histogram);
+    cs::println(stream, i + 1 < _num_streams ? "    }," : "    }");
+  }
+  cs::println(stream, "  ]");
+  cs::println(stream, "}");
+}
+
+////// public static /////////////////////////////////////////////////////////
+
+Report Report::run(const cs::Buffer& buffer, const Wrap& wrap)
+{
+  Report report;
+
+  BufferReader reader{buffer};
+  forEachBlock(reader, wrap, [&](const Block& block) -> void {
+    report.add(block);
+  });
+  report.finish();
+
+  return report;
+}
+
+Report Report::run(BlockFile& file)
+{
+  Report report;
+
+  file.findWrap();
+  for( Block block = file.first(); block.isValid(); block = file.next(block) ) {
+    report.add(block);
+  }
+  report.finish();
+
+  return report;
+}
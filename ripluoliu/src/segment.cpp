@@ -0,0 +1,211 @@
+/****************************************************************************
+** Copyright (c) 2023, Carsten Schmidt. All rights reserved.
+**
+** Redistribution and use in source and binary forms, with or without
+** modification, are permitted provided that the following conditions
+** are met:
+**
+** 1. Redistributions of source code must retain the above copyright
+**    notice, this list of conditions and the following disclaimer.
+**
+** 2. Redistributions in binary form must reproduce the above copyright
+**    notice, this list of conditions and the following disclaimer in the
+**    documentation and/or other materials provided with the distribution.
+**
+** 3. Neither the name of the copyright holder nor the names of its
+**    contributors may be used to endorse or promote products derived from
+**    this software without specific prior written permission.
+**
+** THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+** "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+** LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+** A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+** HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+** SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+** LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+** DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+** THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+** (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+** OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*****************************************************************************/
+
+#include <cstdio>
+
+#include <algorithm>
+
+#include <cs/IO/File.h>
+#include <cs/Text/PrintFormat.h>
+#include <cs/Text/PrintUtil.h>
+#include <cs/Text/StringUtil.h>
+
+#include "segment.h"
+
+////// Segmentation - public /////////////////////////////////////////////////
+
+bool Segmentation::isEnabled() const
+{
+  return duration > 0 || size > 0;
+}
+
+////// WriterPool - public ///////////////////////////////////////////////////
+
+WriterPool::WriterPool(const std::size_t numThreads) noexcept
+{
+  const std::size_t count = numThreads > 0
+                            ? numThreads
+                            : std::max<std::size_t>(std::thread::hardware_concurrency() / 2, 1);
+
+  _max_jobs = count * 2;
+  for( std::size_t i = 0; i < count; i++ ) {
+    _threads.emplace_back(&WriterPool::work, this);
+  }
+}
+
+WriterPool::~WriterPool() noexcept
+{
+  finish();
+}
+
+void WriterPool::submit(Job job)
+{
+  std::unique_lock<std::mutex> lock(_mutex);
+  _cond_space.wait(lock, [this]() -> bool {
+    return _jobs.size() < _max_jobs;
+  });
+
+  _jobs.push_back(std::move(job));
+  _cond_jobs.notify_one();
+}
+
+bool WriterPool::finish()
+{
+  {
+    std::lock_guard<std::mutex> lock(_mutex);
+    _is_finished = true;
+  }
+  _cond_jobs.notify_all();
+
+  for( std::thread& thread : _threads ) {
+    thread.join();
+  }
+  _threads.clear();
+
+  return _num_failed == 0;
+}
+
+////// WriterPool - private //////////////////////////////////////////////////
+
+void WriterPool::work()
+{
+  for( ;; ) {
+    Job job;
+    {
+      std::unique_lock<std::mutex> lock(_mutex);
+      _cond_jobs.wait(lock, [this]() -> bool {
+        return _is_finished || !_jobs.empty();
+      });
+
+      if( _jobs.empty() ) {
+        return;
+      }
+
+      job = std::move(_jobs.front());
+      _jobs.pop_front();
+    }
+    _cond_space.notify_one();
+
+    cs::File file;
+    bool is_ok = file.open(job.path, cs::FileOpenFlag::Write | cs::FileOpenFlag::Truncate);
+    for( std::size_t i = 0; is_ok && i < job.spans.size(); i++ ) {
+      is_ok = file.write(job.spans[i].data, job.spans[i].size) == job.spans[i].size;
+    }
+
+    if( !is_ok ) {
+      fprintf(stderr, "ERROR: Unable to write segment \"%s\"!\n", job.path.string().data());
+
+      std::lock_guard<std::mutex> lock(_mutex);
+      _num_failed++;
+    }
+  }
+}
+
+////// SegmentSink - public //////////////////////////////////////////////////
+
+SegmentSink::~SegmentSink() noexcept
+{
+}
+
+void SegmentSink::write(const Block& block,
+                        const cs::byte_t *data, const std::size_t size)
+{
+  _has_keys = _has_keys || block.is_key;
+
+  // NOTE: A block may be passed on in parts (cf. NalSink); only split
+  //       between blocks.
+  const bool is_new_block = _job.spans.empty() || block.offset != _offset;
+  _offset                 = block.offset;
+
+  const bool is_exceeded = (_segmentation.duration > 0 && block.timestamp - _tim_begin >= _segmentation.duration)
+                           || (_segmentation.size > 0 && _size >= _segmentation.size);
+
+  if( !_job.spans.empty() && is_new_block && is_exceeded && (block.is_key || !_has_keys) ) {
+    flush();
+  }
+
+  if( _job.spans.empty() ) {
+    _tim_begin = block.timestamp;
+  }
+
+  _job.spans.push_back({data, size});
+  _size += size;
+}
+
+void SegmentSink::close()
+{
+  flush();
+}
+
+SinkPtr SegmentSink::make(WriterPool *pool, const Segmentation& segmentation,
+                          const std::filesystem::path& input,
+                          const Block::id_stream_t id_stream, const FourCC& fourcc)
+{
+  if( pool == nullptr || !segmentation.isEnabled() ) {
+    return SinkPtr();
+  }
+
+  std::unique_ptr<SegmentSink> sink(new SegmentSink());
+  sink->_pool         = pool;
+  sink->_segmentation = segmentation;
+  sink->_prefix       = cs::sprint("%-0x%-", input.stem().string(), cs::hexf(id_stream, true));
+  sink->_suffix       = cs::sprint(".%", cs::toLower(toString(fourcc)));
+
+  return sink;
+}
+
+////// SegmentSink - private /////////////////////////////////////////////////
+
+SegmentSink::SegmentSink() noexcept
+{
+}
+
+void SegmentSink::flush()
+{
+  if( _job.spans.empty() ) {
+    return;
+  }
+
+  // NOTE: The name is precomputed except for the number; the next job reserves
+  //       as many spans as this one needed.
+  char number[24];
+  snprintf(number, sizeof(number), "%04zu", _number);
+
+  const std::size_t numSpans = _job.spans.size();
+
+  _job.path = _prefix + number + _suffix;
+  _pool->submit(std::move(_job));
+
+  _job = WriterPool::Job();
+  _job.spans.reserve(numSpans);
+  _number++;
+  _size = 0;
+}
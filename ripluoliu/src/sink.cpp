@@ -0,0 +1,101 @@
+/****************************************************************************
+** Copyright (c) 2023, Carsten Schmidt. All rights reserved.
+**
+** Redistribution and use in source and binary forms, with or without
+** modification, are permitted provided that the following conditions
+** are met:
+**
+** 1. Redistributions of source code must retain the above copyright
+**    notice, this list of conditions and the following disclaimer.
+**
+** 2. Redistributions in binary form must reproduce the above copyright
+**    notice, this list of conditions and the following disclaimer in the
+**    documentation and/or other materials provided with the distribution.
+**
+** 3. Neither the name of the copyright holder nor the names of its
+**    contributors may be used to endorse or promote products derived from
+**    this software without specific prior written permission.
+**
+** THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+** "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+** LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+** A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+** HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+** SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+** LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+** DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+** THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+** (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+** OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*****************************************************************************/
+
+#include <cs/Text/PrintFormat.h>
+#include <cs/Text/PrintUtil.h>
+#include <cs/Text/StringUtil.h>
+
+#include "sink.h"
+
+////// Sink - public /////////////////////////////////////////////////////////
+
+Sink::~Sink() noexcept
+{
+}
+
+void Sink::close()
+{
+}
+
+bool Sink::checksKeyFrames() const
+{
+  return false;
+}
+
+////// Sink - protected //////////////////////////////////////////////////////
+
+Sink::Sink() noexcept
+{
+}
+
+////// FileSink - public /////////////////////////////////////////////////////
+
+FileSink::~FileSink() noexcept
+{
+}
+
+void FileSink::write(const Block& /*block*/,
+                     const cs::byte_t *data, const std::size_t size)
+{
+  _file.write(data, size);
+}
+
+void FileSink::close()
+{
+  _file.close();
+}
+
+SinkPtr FileSink::make(const std::filesystem::path& path)
+{
+  std::unique_ptr<FileSink> sink(new FileSink());
+  if( !sink->_file.open(path, cs::FileOpenFlag::Write | cs::FileOpenFlag::Truncate) ) {
+    return SinkPtr();
+  }
+
+  return sink;
+}
+
+////// FileSink - private ////////////////////////////////////////////////////
+
+FileSink::FileSink() noexcept
+{
+}
+
+////// Public ////////////////////////////////////////////////////////////////
+
+std::filesystem::path outputPath(const std::filesystem::path& input,
+                                 const Block::id_stream_t id_stream, const FourCC& fourcc)
+{
+  return cs::sprint("%-0x%.%",
+                    input.stem().string(),
+                    cs::hexf(id_stream, true),
+                    cs::toLower(toString(fourcc)));
+}
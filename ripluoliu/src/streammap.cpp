@@ -0,0 +1,136 @@
+/****************************************************************************
+** Copyright (c) 2023, Carsten Schmidt. All rights reserved.
+**
+** Redistribution and use in source and binary forms, with or without
+** modification, are permitted provided that the following conditions
+** are met:
+**
+** 1. Redistributions of source code must retain the above copyright
+**    notice, this list of conditions and the following disclaimer.
+**
+** 2. Redistributions in binary form must reproduce the above copyright
+**    notice, this list of conditions and the following disclaimer in the
+**    documentation and/or other materials provided with the distribution.
+**
+** 3. Neither the name of the copyright holder nor the names of its
+**    contributors may be used to endorse or promote products derived from
+**    this software without specific prior written permission.
+**
+** THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+** "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+** LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+** A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+** HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+** SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+** LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+** DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+** THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+** (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+** OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*****************************************************************************/
+
+#include <algorithm>
+
+#include <cs/Text/PrintFormat.h>
+#include <cs/Text/PrintUtil.h>
+
+#include "streammap.h"
+
+////// public ////////////////////////////////////////////////////////////////
+
+StreamMap::StreamMap() noexcept
+{
+}
+
+bool StreamMap::isEmpty() const
+{
+  return _spans.empty();
+}
+
+std::size_t StreamMap::size() const
+{
+  return _size;
+}
+
+const std::vector<StreamMap::Span>& StreamMap::spans() const
+{
+  return _spans;
+}
+
+void StreamMap::clear()
+{
+  _spans.clear();
+  _size = 0;
+}
+
+void StreamMap::add(const Block& block)
+{
+  if( block.block_size == 0 ) {
+    return;
+  }
+
+  _spans.push_back({_size, block.data(), static_cast<uint32_t>(block.block_size)});
+  _size += block.block_size;
+}
+
+std::size_t StreamMap::read(const BlockFile& file, const std::size_t offset,
+                            void *data, const std::size_t size) const
+{
+  if( offset >= _size || size == 0 ) {
+    return 0;
+  }
+
+  // (1) Find Span Holding 'offset' //////////////////////////////////////////
+
+  auto span = std::upper_bound(_spans.begin(), _spans.end(), offset,
+                               [](const std::size_t offset, const Span& span) -> bool {
+                                 return offset < span.offset;
+                               });
+  --span;
+
+  // (2) Gather Spans ////////////////////////////////////////////////////////
+
+  cs::byte_t *dest = static_cast<cs::byte_t *>(data);
+
+  std::size_t numRead = 0;
+  for( std::size_t skip = offset - span->offset;
+       numRead < size && span != _spans.end();
+       ++span, skip = 0 ) {
+    const std::size_t count = std::min<std::size_t>(span->size - skip, size - numRead);
+    if( file.read(span->data + skip, dest + numRead, count) != count ) {
+      break;
+    }
+    numRead += count;
+  }
+
+  return numRead;
+}
+
+void StreamMap::print(std::ostream *stream) const
+{
+  for( const Span& span : _spans ) {
+    cs::println(stream, "0x% -> 0x% (%)",
+                cs::hexf(span.offset, true),
+                cs::hexf(span.data, true),
+                span.size);
+  }
+}
+
+////// public static /////////////////////////////////////////////////////////
+
+StreamMap StreamMap::build(BlockFile& file,
+                           const Block::id_stream_t id_stream, const FourCC& fourcc)
+{
+  StreamMap map;
+
+  file.findWrap();
+  for( Block block = file.first(); block.isValid(); block = file.next(block) ) {
+    if( block.id_stream != id_stream || block.fourcc != fourcc ) {
+      continue;
+    }
+
+    map.add(block);
+  }
+
+  return map;
+}
@@ -29,6 +29,7 @@
 ** OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 *****************************************************************************/
 
+#include <algorithm>
 #include <iostream>
 
 #include <cs/Text/Print.h>
@@ -39,12 +40,36 @@
 #include "fourcc.h"
 #include "util.h"
 
+////// Private ///////////////////////////////////////////////////////////////
+
+namespace impl_toc {
+
+  constexpr FourCC TAG_BEGIN{'l', 'u', 'o', ' '};
+  constexpr FourCC TAG_END{' ', 'o', 'u', 'l'};
+
+  constexpr std::size_t OFFS_TIME_BEGIN        = 0x4;
+  constexpr std::size_t OFFS_TIME_END          = 0x8;
+  constexpr std::size_t OFFS_TIME_STREAM_BEGIN = 0x08C;
+  constexpr std::size_t OFFS_TIME_STREAM_END1  = 0x18C;
+  constexpr std::size_t OFFS_ID_CAMERA         = 0x20C;
+  constexpr std::size_t OFFS_ID_STREAM         = 0x28C;
+  constexpr std::size_t OFFS_TIME_STREAM_END2  = 0x30C;
+  constexpr std::size_t OFFS_NUM_BLOCKS        = 0x38C;
+  constexpr std::size_t OFFS_SIZ_STREAM        = 0x40C;
+
+} // namespace impl_toc
+
 ////// public ////////////////////////////////////////////////////////////////
 
 Toc::Toc() noexcept
 {
 }
 
+bool Toc::isValid() const
+{
+  return _is_valid;
+}
+
 void Toc::print(std::ostream *stream) const
 {
   cs::println(stream, "tim_begin = %", formatTime(tim_begin));
@@ -72,22 +97,48 @@ void Toc::print() const
   print(&std::cout);
 }
 
+bool Toc::write(cs::Buffer& buffer, const std::size_t offset) const
+{
+  using namespace impl_toc;
+
+  if( offset + SIZE_TOC > buffer.size() ) {
+    return false;
+  }
+
+  // Helper ////////////////////////////////////////////////////////////////
+
+  cs::byte_t *data = buffer.data() + offset;
+
+  // Tags //////////////////////////////////////////////////////////////////
+
+  std::copy(TAG_BEGIN.begin(), TAG_BEGIN.end(), data);
+  std::copy(TAG_END.begin(), TAG_END.end(), data + SIZE_TOC - SIZE_FOURCC);
+
+  // Time Stamps ///////////////////////////////////////////////////////////
+
+  writeInt(data, OFFS_TIME_BEGIN, static_cast<timestamp_t>(tim_begin));
+  writeInt(data, OFFS_TIME_END, static_cast<timestamp_t>(tim_end));
+
+  // Streams ///////////////////////////////////////////////////////////////
+
+  for( std::size_t i = 0; i < NUM_STREAMS; i++ ) {
+    writeInt(data, OFFS_ID_STREAM, id_stream[i], i);
+    writeInt(data, OFFS_ID_CAMERA, id_camera[i], i);
+    writeInt(data, OFFS_NUM_BLOCKS, num_blocks[i], i);
+    writeInt(data, OFFS_SIZ_STREAM, siz_stream[i], i);
+    writeInt(data, OFFS_TIME_STREAM_BEGIN, static_cast<timestamp_t>(tim_stream_begin[i]), i);
+    writeInt(data, OFFS_TIME_STREAM_END1, static_cast<timestamp_t>(tim_stream_end1[i]), i);
+    writeInt(data, OFFS_TIME_STREAM_END2, static_cast<timestamp_t>(tim_stream_end2[i]), i);
+  }
+
+  return true;
+}
+
 ////// public static /////////////////////////////////////////////////////////
 
 Toc Toc::read(const cs::Buffer& buffer, const std::size_t offset)
 {
-  constexpr FourCC TAG_BEGIN{'l', 'u', 'o', ' '};
-  constexpr FourCC TAG_END{' ', 'o', 'u', 'l'};
-
-  constexpr std::size_t OFFS_TIME_BEGIN        = 0x4;
-  constexpr std::size_t OFFS_TIME_END          = 0x8;
-  constexpr std::size_t OFFS_TIME_STREAM_BEGIN = 0x08C;
-  constexpr std::size_t OFFS_TIME_STREAM_END1  = 0x18C;
-  constexpr std::size_t OFFS_ID_CAMERA         = 0x20C;
-  constexpr std::size_t OFFS_ID_STREAM         = 0x28C;
-  constexpr std::size_t OFFS_TIME_STREAM_END2  = 0x30C;
-  constexpr std::size_t OFFS_NUM_BLOCKS        = 0x38C;
-  constexpr std::size_t OFFS_SIZ_STREAM        = 0x40C;
+  using namespace impl_toc;
 
   // Sanity Check ////////////////////////////////////////////////////////////
 
@@ -111,6 +162,8 @@ Toc Toc::read(const cs::Buffer& buffer, const std::size_t offset)
 
   Toc toc;
 
+  toc._is_valid = true;
+
   // Parse Time Stamps /////////////////////////////////////////////////////
 
   toc.tim_begin = readInt<timestamp_t>(data, OFFS_TIME_BEGIN);
@@ -29,19 +29,193 @@
 ** OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 *****************************************************************************/
 
-#include <cs/Text/PrintFormat.h>
-#include <cs/Text/PrintUtil.h>
+#include <cstdio>
+
+#include <algorithm>
+#include <charconv>
 
 #include "util.h"
 
+////// Private ///////////////////////////////////////////////////////////////
+
+namespace impl_util {
+
+  bool isReadableDirectory(const std::filesystem::path& path)
+  {
+    std::error_code ec;
+    std::filesystem::directory_iterator it(path, ec);
+    return !ec;
+  }
+
+} // namespace impl_util
+
+////// Public ////////////////////////////////////////////////////////////////
+
+bool walkDirectory(const std::filesystem::path& root, const WalkFunc& func)
+{
+  // NOTE: A failing increment() ends the iteration; hence, unreadable
+  //       directories are reported and skipped before descending into them.
+  constexpr auto options = std::filesystem::directory_options::skip_permission_denied;
+
+  std::error_code ec;
+  std::filesystem::recursive_directory_iterator it(root, options, ec), end;
+  if( ec ) {
+    fprintf(stderr, "ERROR: Unable to scan directory \"%s\"!\n", root.string().data());
+    return false;
+  }
+
+  while( it != end ) {
+    if( !it->is_directory(ec) ) {
+      func(*it);
+    } else if( !impl_util::isReadableDirectory(it->path()) ) {
+      fprintf(stderr, "ERROR: Unable to scan directory \"%s\"!\n", it->path().string().data());
+      it.disable_recursion_pending();
+    }
+
+    const std::filesystem::path current = it->path();
+    if( it.increment(ec); ec ) {
+      fprintf(stderr, "ERROR: Unable to scan beyond \"%s\"!\n", current.string().data());
+      break;
+    }
+  }
+
+  return true;
+}
+
+bool parseSize(const std::string_view s, std::size_t *size)
+{
+  if( s.empty() ) {
+    return false;
+  }
+
+  std::size_t factor = 1;
+  switch( s.back() ) {
+  case 'G':
+  case 'g':
+    factor <<= 10;
+    [[fallthrough]];
+  case 'M':
+  case 'm':
+    factor <<= 10;
+    [[fallthrough]];
+  case 'K':
+  case 'k':
+    factor <<= 10;
+    break;
+  default:
+    break;
+  }
+
+  const std::string_view number = factor > 1
+                                  ? s.substr(0, s.size() - 1)
+                                  : s;
+  if( !parseInt(number, size) ) {
+    return false;
+  }
+  *size *= factor;
+
+  return *size > 0;
+}
+
+bool parseDuration(const std::string_view s, std::time_t *duration)
+{
+  if( s.empty() ) {
+    return false;
+  }
+
+  std::time_t factor = 0;
+  switch( s.back() ) {
+  case 'h':
+    factor = 3600;
+    break;
+  case 'm':
+    factor = 60;
+    break;
+  case 's':
+    factor = 1;
+    break;
+  default:
+    break;
+  }
+
+  const std::string_view number = factor > 0
+                                  ? s.substr(0, s.size() - 1)
+                                  : s;
+  if( !parseInt(number, duration) ) {
+    return false;
+  }
+  *duration *= std::max<std::time_t>(factor, 1);
+
+  return *duration > 0;
+}
+
 std::string formatTime(const std::time_t t)
 {
-  const std::tm time = *std::gmtime(&t);
-  return cs::sprint("%%%-%%%",
-                    cs::decf(time.tm_year + 1900, 4, '0'),
-                    cs::decf(time.tm_mon + 1, 2, '0'),
-                    cs::decf(time.tm_mday, 2, '0'),
-                    cs::decf(time.tm_hour, 2, '0'),
-                    cs::decf(time.tm_min, 2, '0'),
-                    cs::decf(time.tm_sec, 2, '0'));
+  // NOTE: Formatted in place; the 15 characters fit the small string buffer
+  //       of std::string, hence no allocation per printed time stamp.
+  //       The reentrant gmtime_r()/gmtime_s() are required by the daemon's
+  //       workers.
+  std::tm time{};
+#ifdef _WIN32
+  if( gmtime_s(&time, &t) != 0 ) {
+    return std::string();
+  }
+#else
+  if( gmtime_r(&t, &time) == nullptr ) {
+    return std::string();
+  }
+#endif
+
+  char text[32];
+  const int length = snprintf(text, sizeof(text), "%04d%02d%02d-%02d%02d%02d",
+                              time.tm_year + 1900, time.tm_mon + 1, time.tm_mday,
+                              time.tm_hour, time.tm_min, time.tm_sec);
+
+  return length > 0
+         ? std::string(text, std::min<std::size_t>(length, sizeof(text) - 1))
+         : std::string();
+}
+
+bool parseTime(const std::string_view s, std::time_t *t)
+{
+  const auto parse = [&](const std::size_t pos, const std::size_t len, int *value) -> bool {
+    const char *first = s.data() + pos;
+    const char *last  = first + len;
+    return std::from_chars(first, last, *value).ptr == last;
+  };
+
+  if( s.empty() || t == nullptr ) {
+    return false;
+  }
+
+  // (1) Seconds since Epoch /////////////////////////////////////////////////
+
+  if( s.size() != 15 || s[8] != '-' ) {
+    unsigned long long secs = 0;
+    if( std::from_chars(s.data(), s.data() + s.size(), secs).ptr != s.data() + s.size() ) {
+      return false;
+    }
+    *t = static_cast<std::time_t>(secs);
+    return true;
+  }
+
+  // (2) YYYYMMDD-hhmmss /////////////////////////////////////////////////////
+
+  int year = 0, mon = 0, day = 0, hour = 0, min = 0, sec = 0;
+  if( !parse(0, 4, &year) || !parse(4, 2, &mon) || !parse(6, 2, &day)
+      || !parse(9, 2, &hour) || !parse(11, 2, &min) || !parse(13, 2, &sec) ) {
+    return false;
+  }
+
+  // NOTE: Days from civil; cf. H. Hinnant's date algorithms.
+  year -= mon <= 2 ? 1 : 0;
+  const int era         = (year >= 0 ? year : year - 399) / 400;
+  const int year_of_era = year - era * 400;
+  const int day_of_year = (153 * (mon + (mon > 2 ? -3 : 9)) + 2) / 5 + day - 1;
+  const int day_of_era  = year_of_era * 365 + year_of_era / 4 - year_of_era / 100 + day_of_year;
+  const long long days  = static_cast<long long>(era) * 146097 + day_of_era - 719468;
+
+  *t = static_cast<std::time_t>(days * 86400 + hour * 3600 + min * 60 + sec);
+
+  return true;
 }
@@ -0,0 +1,240 @@
+/****************************************************************************
+** Copyright (c) 2023, Carsten Schmidt. All rights reserved.
+**
+** Redistribution and use in source and binary forms, with or without
+** modification, are permitted provided that the following conditions
+** are met:
+**
+** 1. Redistributions of source code must retain the above copyright
+**    notice, this list of conditions and the following disclaimer.
+**
+** 2. Redistributions in binary form must reproduce the above copyright
+**    notice, this list of conditions and the following disclaimer in the
+**    documentation and/or other materials provided with the distribution.
+**
+** 3. Neither the name of the copyright holder nor the names of its
+**    contributors may be used to endorse or promote products derived from
+**    this software without specific prior written permission.
+**
+** THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+** "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+** LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+** A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+** HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+** SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+** LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+** DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+** THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+** (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+** OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*****************************************************************************/
+
+#include <algorithm>
+#include <iostream>
+#include <vector>
+
+#include <cs/Text/PrintFormat.h>
+#include <cs/Text/PrintUtil.h>
+
+#include "wrap.h"
+
+#include "blockfile.h"
+
+////// Private ///////////////////////////////////////////////////////////////
+
+namespace impl_wrap {
+
+  inline bool isDrop(const std::time_t from, const std::time_t to,
+                     const std::time_t threshold)
+  {
+    return to + threshold < from;
+  }
+
+  template <typename Reader>
+  Wrap find(Reader& reader, const std::time_t threshold)
+  {
+    constexpr std::size_t MIN_PROBES    = 16;
+    constexpr std::size_t MAX_PROBES    = 1024;
+    constexpr std::size_t SIZE_BISECTED = 0x10000;
+
+    if( reader.size() <= Toc::SIZE_TOC ) {
+      return Wrap();
+    }
+
+    // (1) Sample Timestamps /////////////////////////////////////////////////
+
+    const std::size_t size      = reader.size() - Toc::SIZE_TOC;
+    const std::size_t numProbes = std::clamp<std::size_t>(size >> 20, MIN_PROBES, MAX_PROBES);
+
+    std::vector<Block> probes;
+    for( std::size_t i = 0; i < numProbes; i++ ) {
+      const Block block = reader.resync(Toc::SIZE_TOC + size / numProbes * i);
+      if( !block.isValid() ) {
+        break;
+      }
+
+      if( probes.empty() || block.offset > probes.back().offset ) {
+        probes.push_back(block);
+      }
+    }
+
+    // (2) Find Sharpest Drop ////////////////////////////////////////////////
+
+    std::size_t drop = probes.size();
+    for( std::size_t i = 1; i < probes.size(); i++ ) {
+      const std::time_t from = probes[i - 1].timestamp;
+      const std::time_t to   = probes[i].timestamp;
+      if( !isDrop(from, to, threshold) ) {
+        continue;
+      }
+
+      if( drop == probes.size() || from - to > probes[drop - 1].timestamp - probes[drop].timestamp ) {
+        drop = i;
+      }
+    }
+
+    if( drop == probes.size() ) {
+      return Wrap();
+    }
+
+    // (3) Verify Order //////////////////////////////////////////////////////
+
+    // NOTE: The oldest blocks, which end at EOF, precede the newest blocks at
+    //       Toc::SIZE_TOC; after a backward step of the clock of a linear
+    //       recording (e.g. DST, NTP) the blocks at EOF are newer instead.
+    std::time_t newestAtEof = probes.back().timestamp;
+    for( Block block = probes.back(); ; ) {
+      const Block next = reader.readBlock(block.next());
+      if( !next.isValid() ) {
+        break;
+      }
+
+      newestAtEof = std::max(newestAtEof, next.timestamp);
+      block       = next;
+    }
+
+    if( isDrop(newestAtEof, probes.front().timestamp, threshold) ) {
+      return Wrap();
+    }
+
+    // (4) Bisect ////////////////////////////////////////////////////////////
+
+    Block lo = probes[drop - 1];
+    Block hi = probes[drop];
+    while( hi.offset - lo.offset > SIZE_BISECTED ) {
+      const Block mid = reader.resync(lo.offset + (hi.offset - lo.offset) / 2);
+      if( !mid.isValid() || mid.offset >= hi.offset || mid.offset <= lo.offset ) {
+        break;
+      }
+
+      if( isDrop(lo.timestamp, mid.timestamp, threshold) ) {
+        hi = mid;
+      } else {
+        lo = mid;
+      }
+    }
+
+    // (5) Walk Chain to Wrap Point //////////////////////////////////////////
+
+    std::time_t newest = lo.timestamp;
+    for( Block block = lo; block.offset < hi.offset; ) {
+      const Block next = reader.readBlock(block.next());
+
+      // (5.1) Chain is broken; the oldest block follows the overwritten rest.
+      if( !next.isValid() ) {
+        const Block oldest = reader.resync(block.next());
+        if( !oldest.isValid() || !isDrop(newest, oldest.timestamp, threshold) ) {
+          break;
+        }
+
+        Wrap wrap;
+        wrap.begin = oldest.offset;
+        wrap.end   = block.next();
+        return wrap;
+      }
+
+      // (5.2) Chain continues across the wrap point.
+      if( isDrop(newest, next.timestamp, threshold) ) {
+        Wrap wrap;
+        wrap.begin = next.offset;
+        wrap.end   = next.offset;
+        return wrap;
+      }
+
+      newest = std::max(newest, next.timestamp);
+      block  = next;
+    }
+
+    return Wrap();
+  }
+
+} // namespace impl_wrap
+
+////// Wrap - public /////////////////////////////////////////////////////////
+
+bool Wrap::isWrapped() const
+{
+  return begin != 0;
+}
+
+void Wrap::print(std::ostream *stream) const
+{
+  if( !isWrapped() ) {
+    return;
+  }
+
+  cs::println(stream, "wrap_begin = 0x%", cs::hexf(begin));
+  cs::println(stream, "wrap_end   = 0x%", cs::hexf(end));
+  cs::println(stream, "");
+}
+
+void Wrap::print() const
+{
+  print(&std::cout);
+}
+
+////// Wrap - public static //////////////////////////////////////////////////
+
+Wrap Wrap::find(const cs::Buffer& buffer, const std::time_t threshold)
+{
+  BufferReader reader{buffer};
+  return impl_wrap::find(reader, threshold);
+}
+
+Wrap Wrap::find(BlockFile& file, const std::time_t threshold)
+{
+  return impl_wrap::find(file, threshold);
+}
+
+////// BufferReader - public /////////////////////////////////////////////////
+
+std::size_t BufferReader::size() const
+{
+  return buffer.size();
+}
+
+Block BufferReader::readBlock(const std::size_t offset) const
+{
+  return Block::read(buffer, offset);
+}
+
+Block BufferReader::resync(const std::size_t pos) const
+{
+  constexpr cs::byte_t TAG_BEGIN[4] = {'l', 'i', 'u', ' '};
+
+  for( auto it = buffer.begin() + std::min(pos, buffer.size());
+       (it = std::search(it, buffer.end(), TAG_BEGIN, TAG_BEGIN + 4)) != buffer.end();
+       ++it ) {
+    const Block block = Block::read(buffer, it - buffer.begin());
+    if( !block.isValid() ) {
+      continue;
+    }
+
+    if( block.next() + Block::SIZE_BLOCK_HEADER > buffer.size()
+        || Block::read(buffer, block.next()).isValid() ) {
+      return block;
+    }
+  }
+
+  return Block();
+}
@@ -0,0 +1,93 @@
+/****************************************************************************
+** Copyright (c) 2023, Carsten Schmidt. All rights reserved.
+**
+** Redistribution and use in source and binary forms, with or without
+** modification, are permitted provided that the following conditions
+** are met:
+**
+** 1. Redistributions of source code must retain the above copyright
+**    notice, this list of conditions and the following disclaimer.
+**
+** 2. Redistributions in binary form must reproduce the above copyright
+**    notice, this list of conditions and the following disclaimer in the
+**    documentation and/or other materials provided with the distribution.
+**
+** 3. Neither the name of the copyright holder nor the names of its
+**    contributors may be used to endorse or promote products derived from
+**    this software without specific prior written permission.
+**
+** THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+** "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+** LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+** A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+** HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+** SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+** LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+** DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+** THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+** (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+** OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*****************************************************************************/
+
+#include <cstdlib>
+
+#include <atomic>
+#include <new>
+
+#include "alloc.h"
+
+////// Private ///////////////////////////////////////////////////////////////
+
+namespace impl_alloc {
+
+  std::atomic<std::size_t> numAllocations{0};
+
+  void *allocate(std::size_t size)
+  {
+    numAllocations.fetch_add(1, std::memory_order_relaxed);
+
+    void *ptr = std::malloc(size > 0 ? size : 1);
+    if( ptr == nullptr ) {
+      throw std::bad_alloc();
+    }
+    return ptr;
+  }
+
+} // namespace impl_alloc
+
+void *operator new(std::size_t size)
+{
+  return impl_alloc::allocate(size);
+}
+
+void *operator new[](std::size_t size)
+{
+  return impl_alloc::allocate(size);
+}
+
+void operator delete(void *ptr) noexcept
+{
+  std::free(ptr);
+}
+
+void operator delete[](void *ptr) noexcept
+{
+  std::free(ptr);
+}
+
+void operator delete(void *ptr, std::size_t /*size*/) noexcept
+{
+  std::free(ptr);
+}
+
+void operator delete[](void *ptr, std::size_t /*size*/) noexcept
+{
+  std::free(ptr);
+}
+
+////// Public ////////////////////////////////////////////////////////////////
+
+std::size_t numAllocations()
+{
+  return impl_alloc::numAllocations.load(std::memory_order_relaxed);
+}
@@ -0,0 +1,214 @@
+/****************************************************************************
+** Copyright (c) 2023, Carsten Schmidt. All rights reserved.
+**
+** Redistribution and use in source and binary forms, with or without
+** modification, are permitted provided that the following conditions
+** are met:
+**
+** 1. Redistributions of source code must retain the above copyright
+**    notice, this list of conditions and the following disclaimer.
+**
+** 2. Redistributions in binary form must reproduce the above copyright
+**    notice, this list of conditions and the following disclaimer in the
+**    documentation and/or other materials provided with the distribution.
+**
+** 3. Neither the name of the copyright holder nor the names of its
+**    contributors may be used to endorse or promote products derived from
+**    this software without specific prior written permission.
+**
+** THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+** "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+** LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+** A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+** HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+** SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+** LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+** DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+** THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+** (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+** OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*****************************************************************************/
+
+#include <cstdio>
+#include <cstdlib>
+
+#include <algorithm>
+#include <filesystem>
+
+#include "alloc.h"
+#include "filter.h"
+#include "nal.h"
+#include "util.h"
+
+// NOTE: Demux a small file built in memory through a FileSink and a NalSink;
+//       once the sinks are created, no heap allocation must happen.
+
+////// Private ///////////////////////////////////////////////////////////////
+
+namespace impl_test {
+
+  constexpr std::size_t NUM_BLOCKS = 64;
+
+  constexpr Block::id_stream_t ID_VIDEO = 0x10;
+  constexpr Block::id_stream_t ID_AUDIO = 0x20;
+
+  constexpr Toc::id_camera_t ID_CAMERA = 3;
+
+  constexpr std::time_t TIM_BEGIN = 1700000000;
+
+  // NOTE: An SPS, a PPS and an IDR slice, or a single non-IDR slice.
+  constexpr cs::byte_t NAL_KEY[] = {
+    0, 0, 0, 1, 0x67, 0x42, 0x00, 0x1F,
+    0, 0, 0, 1, 0x68, 0xCE, 0x38, 0x80,
+    0, 0, 1, 0x65, 0x88, 0x84, 0x21, 0x43
+  };
+  constexpr cs::byte_t NAL_SLICE[] = {
+    0, 0, 0, 1, 0x41, 0x9A, 0x02, 0x04, 0x08
+  };
+  constexpr cs::byte_t PCM[] = {
+    0x10, 0x20, 0x30, 0x40, 0x50, 0x60, 0x70, 0x80
+  };
+
+  void appendBlock(cs::Buffer& buffer, const Block::id_stream_t id_stream, const char *fourcc,
+                   const bool is_key, const std::time_t timestamp,
+                   const cs::byte_t *payload, const std::size_t size)
+  {
+    const std::size_t offset = buffer.size();
+    buffer.resize(offset + Block::SIZE_BLOCK_HEADER + size);
+
+    cs::byte_t *data = buffer.data() + offset;
+    std::fill(data, data + Block::SIZE_BLOCK_HEADER, 0);
+    std::copy(payload, payload + size, data + Block::SIZE_BLOCK_HEADER);
+
+    constexpr FourCC TAG_BEGIN{'l', 'i', 'u', ' '};
+    constexpr FourCC TAG_END{' ', 'u', 'i', 'l'};
+
+    const FourCC code = makeFourCC(fourcc);
+    std::copy(TAG_BEGIN.begin(), TAG_BEGIN.end(), data);
+    std::copy(code.begin(), code.end(), data + 0x18);
+    std::copy(TAG_END.begin(), TAG_END.end(), data + Block::SIZE_BLOCK_HEADER - SIZE_FOURCC);
+
+    writeInt(data, 0x04, id_stream);
+    writeInt(data, 0x24, uint32_t{is_key ? 1u : 0u});
+    writeInt(data, 0x28, ID_CAMERA);
+    writeInt(data, 0x3C, static_cast<uint32_t>(size));
+    writeInt(data, 0x48, static_cast<uint32_t>(timestamp));
+  }
+
+  cs::Buffer makeFile()
+  {
+    Toc toc;
+    toc.tim_begin    = TIM_BEGIN;
+    toc.tim_end      = TIM_BEGIN + NUM_BLOCKS - 1;
+    toc.id_stream[0] = ID_VIDEO;
+    toc.id_stream[1] = ID_AUDIO;
+    toc.id_camera[0] = ID_CAMERA;
+    toc.id_camera[1] = ID_CAMERA;
+
+    cs::Buffer buffer(Toc::SIZE_TOC);
+    std::fill(buffer.begin(), buffer.end(), 0);
+    toc.write(buffer);
+
+    for( std::size_t i = 0; i < NUM_BLOCKS; i++ ) {
+      const std::time_t timestamp = TIM_BEGIN + static_cast<std::time_t>(i);
+
+      // NOTE: The header's key frame flag is deliberately wrong.
+      const bool is_key = i % 8 == 0;
+      appendBlock(buffer, ID_VIDEO, "H264", !is_key, timestamp,
+                  is_key ? NAL_KEY : NAL_SLICE,
+                  is_key ? sizeof(NAL_KEY) : sizeof(NAL_SLICE));
+      appendBlock(buffer, ID_AUDIO, "PCMA", false, timestamp,
+                  PCM, sizeof(PCM));
+    }
+
+    return buffer;
+  }
+
+  bool run(const std::filesystem::path& dir, const bool is_key_only)
+  {
+    const cs::Buffer buffer = makeFile();
+
+    Filter filter;
+    filter.fourccs     = {makeFourCC("H264"), makeFourCC("PCMA")};
+    filter.is_key_only = is_key_only;
+    filter.compile(Toc::read(buffer), [&](const Block::id_stream_t id_stream, const FourCC& fourcc) -> SinkPtr {
+      const std::filesystem::path output = dir / outputPath("alloc_test.dat", id_stream, fourcc);
+
+      SinkPtr sink = FileSink::make(output);
+
+      const NalCodec codec = nalCodec(fourcc);
+      if( codec != NalCodec::None ) {
+        std::filesystem::path index = output;
+        index += ".nal";
+        sink = NalSink::make(std::move(sink), codec, index, true, is_key_only);
+      }
+
+      return sink;
+    });
+
+    const std::size_t numAllocs = numAllocations();
+    filter.run(buffer);
+    const std::size_t numDemux = numAllocations() - numAllocs;
+
+    filter.close();
+
+    if( numDemux != 0 ) {
+      fprintf(stderr, "FAIL: %zu allocations during demux (key only: %d)!\n",
+              numDemux, is_key_only ? 1 : 0);
+      return false;
+    }
+
+    // NOTE: Audio blocks are never key frames.
+    const std::size_t expected = is_key_only
+                                 ? 0
+                                 : NUM_BLOCKS * sizeof(PCM);
+
+    std::error_code ec;
+    const std::uintmax_t size = std::filesystem::file_size(dir / outputPath("alloc_test.dat", ID_AUDIO, makeFourCC("PCMA")), ec);
+    if( ec || size != expected ) {
+      fprintf(stderr, "FAIL: Unexpected output size %ju!\n", size);
+      return false;
+    }
+
+    return true;
+  }
+
+  bool runFormat()
+  {
+    const std::size_t numAllocs = numAllocations();
+    const std::string text      = formatTime(TIM_BEGIN);
+    const std::size_t numFormat = numAllocations() - numAllocs;
+
+    if( numFormat != 0 || text != "20231114-221320" ) {
+      fprintf(stderr, "FAIL: formatTime() returned \"%s\" with %zu allocations!\n",
+              text.data(), numFormat);
+      return false;
+    }
+
+    return true;
+  }
+
+} // namespace impl_test
+
+////// Main //////////////////////////////////////////////////////////////////
+
+int main(int /*argc*/, char ** /*argv*/)
+{
+  using namespace impl_test;
+
+  std::error_code ec;
+  const std::filesystem::path dir = std::filesystem::temp_directory_path() / "ripluoliu_alloc_test";
+  std::filesystem::create_directories(dir, ec);
+  if( ec ) {
+    fprintf(stderr, "ERROR: Unable to create directory!\n");
+    return EXIT_FAILURE;
+  }
+
+  const bool is_ok = run(dir, false) && run(dir, true) && runFormat();
+
+  std::filesystem::remove_all(dir, ec);
+
+  return is_ok
+         ? EXIT_SUCCESS
+         : EXIT_FAILURE;
+}